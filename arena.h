@@ -0,0 +1,68 @@
+#ifndef NAM_ARENA_H
+#define NAM_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**************
+ * PosetArena *
+ **************/
+
+/* Monotonic storage for the many small arrays a poset needs.
+ * allocate() hands out pieces of a few large blocks, and nothing is freed
+ * individually: it all goes at once when the arena is destroyed.
+ * reset() forgets everything allocated but keeps the blocks, so a poset
+ * built again in the same arena makes no new allocations if it fits.
+ * Only for trivially destructible types; no destructors are ever run. */
+class PosetArena {
+    struct Block {
+        std::unique_ptr<char[]> mem;
+        std::size_t size;
+    };
+    std::vector<Block> blocks;
+    std::size_t cur;    // the block being filled
+    std::size_t used;   // bytes used in blocks[cur]
+    std::size_t nalloc; // blocks obtained from the heap, ever
+    std::size_t nbytes; // bytes handed out since the last reset
+
+    static constexpr std::size_t blocksize = 64*1024;
+
+    public:
+    PosetArena() : cur{0}, used{0}, nalloc{0}, nbytes{0} {}
+    PosetArena(PosetArena&&) = default;
+    PosetArena& operator=(PosetArena&&) = default;
+
+    /* Uninitialized room for n objects of type T */
+    template <typename T>
+    T* allocate(std::size_t n) {
+        const std::size_t need = n*sizeof(T);
+        std::size_t at = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+        while (cur < blocks.size() && at + need > blocks[cur].size) {
+            ++cur;
+            at = 0;
+        }
+        if (cur == blocks.size()) {
+            const std::size_t size = need > blocksize ? need : blocksize;
+            blocks.push_back({std::unique_ptr<char[]>{new char[size]}, size});
+            ++nalloc;
+            at = 0;
+        }
+        used = at + need;
+        nbytes += need;
+        return reinterpret_cast<T*>(blocks[cur].mem.get() + at);
+    }
+
+    /* Forget everything allocated, keeping the blocks for reuse */
+    void reset() {
+        cur = used = nbytes = 0;
+    }
+
+    /* Number of blocks ever obtained from the heap */
+    std::size_t allocations() const { return nalloc; }
+
+    /* Bytes handed out since the last reset */
+    std::size_t bytes() const { return nbytes; }
+};
+
+#endif // NAM_ARENA_H
@@ -0,0 +1,5 @@
+#include "bitdiagram.h"
+
+template class BasicBitDiagram<std::uint32_t>;
+template class BasicBitDiagram<std::uint64_t>;
+template class BasicBitDiagram<widemask>;
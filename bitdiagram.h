@@ -0,0 +1,150 @@
+#ifndef NAM_BITDIAGRAM_H
+#define NAM_BITDIAGRAM_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "coxeter.h"
+
+/* A set of nodes of a Coxeter diagram: bit v is set if node v is present. */
+typedef std::uint64_t nodemask;
+
+inline nodemask nodebit(vsize_t v) {
+    return nodemask{1} << v;
+}
+
+/* Index of the lowest set bit. m must be nonzero. */
+inline vsize_t lownode(nodemask m) {
+    return __builtin_ctzll(m);
+}
+
+/* The same for the other words a set of nodes can be kept in, so that code
+ * templated on the word compiles to the plain instructions for each:
+ * MaskBits<Mask>::bits is its width, bit(v) the set {v}, low(m) the index
+ * of the lowest set bit (m nonzero), and count(m) the number of bits set.
+ * There are words of 32, 64 and 128 bits; see BasicBitDiagram. */
+template <typename Mask> struct MaskBits;
+
+template <> struct MaskBits<std::uint32_t> {
+    static constexpr vsize_t bits = 32;
+    static std::uint32_t bit(vsize_t v) { return std::uint32_t{1} << v; }
+    static vsize_t low(std::uint32_t m) { return __builtin_ctz(m); }
+    static vsize_t count(std::uint32_t m) { return __builtin_popcount(m); }
+};
+
+template <> struct MaskBits<std::uint64_t> {
+    static constexpr vsize_t bits = 64;
+    static std::uint64_t bit(vsize_t v) { return std::uint64_t{1} << v; }
+    static vsize_t low(std::uint64_t m) { return __builtin_ctzll(m); }
+    static vsize_t count(std::uint64_t m) { return __builtin_popcountll(m); }
+};
+
+typedef unsigned __int128 widemask;
+
+template <> struct MaskBits<widemask> {
+    static constexpr vsize_t bits = 128;
+    static widemask bit(vsize_t v) { return widemask{1} << v; }
+    static vsize_t low(widemask m) {
+        const std::uint64_t lo = m;
+        return lo ? __builtin_ctzll(lo) : 64 + __builtin_ctzll(std::uint64_t(m >> 64));
+    }
+    static vsize_t count(widemask m) {
+        return __builtin_popcountll(std::uint64_t(m)) + __builtin_popcountll(std::uint64_t(m >> 64));
+    }
+};
+
+/*******************
+ * BasicBitDiagram *
+ *******************/
+
+/* The shape of a Coxeter diagram and its ringed nodes, stored as bitmasks:
+ * one word per node holding its neighbours, and one word for the ringed set.
+ * Deciding whether a subdiagram is a face then takes a few word operations,
+ * with no graph copies and no allocation.
+ * Edge orders are irrelevant here, since they don't affect connectivity.
+ * Mask is the word: std::uint32_t, std::uint64_t (BitDiagram, the one
+ * used everywhere masks are stored), or widemask, and only diagrams with
+ * at most maxnodes (its width) nodes can be represented. */
+template <typename Mask>
+class BasicBitDiagram {
+    typedef MaskBits<Mask> B;
+    std::vector<Mask> adj; // adj[v] is the set of neighbours of v
+    Mask ring;
+
+    public:
+    static constexpr vsize_t maxnodes = B::bits;
+
+    /* Throws std::length_error if cg has more than maxnodes nodes */
+    explicit BasicBitDiagram(const CoxeterGraph& cg);
+
+    vsize_t size() const { return adj.size(); }
+    Mask ringed() const { return ring; }
+    Mask neighbours(vsize_t v) const { return adj[v]; }
+
+    /* The set of all the nodes */
+    Mask all() const {
+        return size() == maxnodes ? ~Mask{0} : B::bit(size()) - 1;
+    }
+
+    /* Check if there is a ringed node in every connected component
+     * of the subdiagram on the nodes in s.
+     * Same as allringed() on the induced subgraph, but done by flooding
+     * outward from the ringed nodes of s, a whole frontier at a time. */
+    bool allringed(Mask s) const {
+        Mask reached = s & ring;
+        Mask frontier = reached;
+        while (frontier) {
+            Mask next = 0;
+            for (; frontier; frontier &= frontier - 1)
+                next |= adj[B::low(frontier)];
+            frontier = next & s & ~reached;
+            reached |= frontier;
+        }
+        return reached == s;
+    }
+
+    /* The connected component of the subdiagram on s containing v.
+     * v must be in s. */
+    Mask component(Mask s, vsize_t v) const {
+        Mask reached = B::bit(v);
+        Mask frontier = reached;
+        while (frontier) {
+            Mask next = 0;
+            for (; frontier; frontier &= frontier - 1)
+                next |= adj[B::low(frontier)];
+            frontier = next & s & ~reached;
+            reached |= frontier;
+        }
+        return reached;
+    }
+};
+
+template <typename Mask>
+constexpr vsize_t BasicBitDiagram<Mask>::maxnodes;
+
+template <typename Mask>
+BasicBitDiagram<Mask>::BasicBitDiagram(const CoxeterGraph& cg)
+  : adj(boost::num_vertices(cg)), ring{0} {
+    if (boost::num_vertices(cg) > maxnodes)
+        throw std::length_error("BitDiagram: too many nodes for a bitmask");
+    auto edgits = boost::edges(cg);
+    for (auto eit = edgits.first; eit != edgits.second; ++eit) {
+        const vsize_t s = boost::source(*eit, cg), t = boost::target(*eit, cg);
+        if (s == t) continue;
+        adj[s] |= B::bit(t);
+        adj[t] |= B::bit(s);
+    }
+    for (vsize_t v = 0; v < boost::num_vertices(cg); ++v) {
+        if (cg[v].ringed)
+            ring |= B::bit(v);
+    }
+}
+
+// compiled once, in bitdiagram.cc
+extern template class BasicBitDiagram<std::uint32_t>;
+extern template class BasicBitDiagram<std::uint64_t>;
+extern template class BasicBitDiagram<widemask>;
+
+typedef BasicBitDiagram<nodemask> BitDiagram;
+
+#endif // NAM_BITDIAGRAM_H
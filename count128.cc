@@ -0,0 +1,22 @@
+#include "count128.h"
+#include "TeXout.h"
+#include <algorithm> // reverse
+#include <ostream>
+
+std::string Count128::str() const {
+    if (n == 0)
+        return "0";
+    std::string s;
+    for (auto v = n; v; v /= 10)
+        s += static_cast<char>('0' + static_cast<int>(v % 10));
+    std::reverse(s.begin(), s.end());
+    return s;
+}
+
+std::ostream& operator<<(std::ostream& os, Count128 c) {
+    return os << c.str();
+}
+
+TeXout& operator<<(TeXout& tex, Count128 c) {
+    return tex << c.str();
+}
@@ -0,0 +1,71 @@
+#ifndef NAM_COUNT128_H
+#define NAM_COUNT128_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+class TeXout; //forward declaration; see TeXout.h
+
+/* Count128: an unsigned 128-bit integer for counting flags and chains.
+ * Arithmetic throws std::overflow_error when the result does not fit,
+ * rather than silently wrapping around (compare BINOM_CHECK in binom.h). */
+class Count128 {
+    unsigned __int128 n;
+
+    public:
+    Count128(std::uint64_t v = 0) : n{v} {}
+
+    Count128& operator+=(Count128 o) {
+        if (__builtin_add_overflow(n, o.n, &n))
+            throw std::overflow_error("Count does not fit in 128 bits.");
+        return *this;
+    }
+
+    Count128& operator-=(Count128 o) {
+        if (__builtin_sub_overflow(n, o.n, &n))
+            throw std::overflow_error("Count would be negative.");
+        return *this;
+    }
+
+    Count128& operator*=(Count128 o) {
+        if (__builtin_mul_overflow(n, o.n, &n))
+            throw std::overflow_error("Count does not fit in 128 bits.");
+        return *this;
+    }
+
+    /* Rounds down; throws std::domain_error when dividing by 0 */
+    Count128& operator/=(Count128 o) {
+        if (o.n == 0)
+            throw std::domain_error("Count divided by zero.");
+        n /= o.n;
+        return *this;
+    }
+
+    friend Count128 operator+(Count128 a, Count128 b) { return a += b; }
+    friend Count128 operator-(Count128 a, Count128 b) { return a -= b; }
+    friend Count128 operator*(Count128 a, Count128 b) { return a *= b; }
+    friend Count128 operator/(Count128 a, Count128 b) { return a /= b; }
+    friend bool operator==(Count128 a, Count128 b) { return a.n == b.n; }
+    friend bool operator!=(Count128 a, Count128 b) { return a.n != b.n; }
+    friend bool operator<(Count128 a, Count128 b) { return a.n < b.n; }
+
+    /* Convert to a narrower integer type, throwing std::overflow_error
+     * if the value does not fit. */
+    template <typename Int>
+    Int as() const {
+        if (n > static_cast<unsigned __int128>(std::numeric_limits<Int>::max()))
+            throw std::overflow_error("Count is too large for the requested type.");
+        return static_cast<Int>(n);
+    }
+
+    /* Decimal representation */
+    std::string str() const;
+};
+
+std::ostream& operator<<(std::ostream& os, Count128 c);
+TeXout& operator<<(TeXout& tex, Count128 c);
+
+#endif // NAM_COUNT128_H
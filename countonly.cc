@@ -2,20 +2,22 @@
  * and from that to a symmetry type graph (a graph of flag orbits.)
  * This gives the number of orbits for t_{i,i+2} for A_n as n goes from 3 to 12.
  * It does not output the hasse diagrams or orbit graphs.
+ * The diagrams are paths, so the counts come from PathCount, with no
+ * subsets; tables of hundreds of nodes take moments.
  */
 
-#include "coxeter.h"
-#include "poset.h"
+#include "pathcount.h"
+#include <algorithm> // max
 #include <cstdio>
 #include <cstdlib> // atoi
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include <numeric> // partial_sum
-#include <boost/algorithm/cxx11/any_of.hpp>
 
 using std::printf;
 using std::putchar;
 using std::vector;
-using boost::algorithm::any_of_equal;
 
 template <typename T>
 int vecsize(vector<T> v) {
@@ -27,28 +29,49 @@ void gapring(int maxnode, vector<int> gaps) {
     gaps.insert(gaps.begin(), 0);
     std::partial_sum(gaps.begin(), gaps.end(), gaps.begin());
     if (maxnode <= gaps.back()) return;
-    /* Header line */
-    printf(" n");
+    /* number of orbits */
+    // Every diagram of the table is a stretch of one path of 2*maxnode
+    // nodes, with the gaps ringed from node maxnode on: t_{i,...} of A_n is
+    // nodes maxnode - i up to maxnode - i + n. So they all share its counts.
+    vector<bool> line(2*maxnode, false);
+    for (int g : gaps)
+        line[maxnode + g] = true;
+    PathCount path{line};
+    vector<std::string> heads;
     for (int i = 0; i < maxnode - gaps.back(); ++i) {
-        for (int j = 0; j < vecsize(gaps); ++ j)
-            if (i + gaps[j] < 10)
-                putchar(' ');
-        printf(" t_%d", i);
+        std::string head = "t_" + std::to_string(i);
         for (int j = 1; j < vecsize(gaps); ++j)
-            printf(",%d", i + gaps[j]);
+            head += "," + std::to_string(i + gaps[j]);
+        heads.push_back(head);
     }
-    putchar('\n');
-    /* number of orbits */
+    // each column is as wide as its widest entry, and a space more
+    vector<std::size_t> widths;
+    for (const auto& head : heads)
+        widths.push_back(std::max(2 + 3*gaps.size(), head.size() + 1));
+    vector<vector<std::string>> rows;
     for (int numnode = gaps.back() + 1; numnode <= maxnode; ++numnode) {
-        CoxeterGraph tcg = linear_coxeter(numnode);
-        printf("%2d", numnode);
+        rows.emplace_back();
         for (int i = 0; i < numnode - gaps.back(); ++i) {
-            for (int v = 0; v < numnode; ++v) {
-                tcg[v].ringed = any_of_equal(gaps, v - i);
+            try {
+                rows.back().push_back(path.flagorbits(maxnode - i, maxnode - i + numnode).str());
+            } catch (const std::overflow_error&) {
+                // t_i(A_n) is (n - 1 choose i), too big past n = 132
+                rows.back().push_back(">2^128");
             }
-            FaceOrbitPoset hasse{tcg};
-            printf("%*d", 2 + 3*vecsize(gaps), hasse.head->numpaths());
+            widths[i] = std::max(widths[i], rows.back().back().size() + 1);
         }
+    }
+    /* Header line */
+    const int nwidth = std::max<int>(2, std::to_string(maxnode).size());
+    printf("%*s", nwidth, "n");
+    for (std::size_t i = 0; i < heads.size(); ++i)
+        printf("%*s", int(widths[i]), heads[i].c_str());
+    putchar('\n');
+    for (int numnode = gaps.back() + 1; numnode <= maxnode; ++numnode) {
+        printf("%*d", nwidth, numnode);
+        const vector<std::string>& row = rows[numnode - gaps.back() - 1];
+        for (std::size_t i = 0; i < row.size(); ++i)
+            printf("%*s", int(widths[i]), row[i].c_str());
         putchar('\n');
     }
 }
@@ -56,7 +79,7 @@ void gapring(int maxnode, vector<int> gaps) {
 int main(int argc, char* argv[]) {
     const int maxnode = argc > 1 ? std::atoi(argv[1]) : 12;
     if (maxnode < 3 || maxnode > 256) {
-        printf("First argument must be positive integer "
+        printf("First argument must be an integer from 3 to 256 "
                "(maximum number of nodes)\n");
         return 1;
     }
@@ -1,6 +1,7 @@
 #include "coxeter.h"
 #include "TeXout.h"
 #include <boost/graph/connected_components.hpp>
+#include <boost/range/iterator_range.hpp>
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <vector>
 #include <algorithm> // min
@@ -121,6 +122,17 @@ CoxeterGraph coxeter_dispatch(char c, unsigned n) {
     }
 }
 
+vsize_t newnode(char c, vsize_t n) {
+    switch(c) {
+        case 'D':
+            return 0;
+        case 'E':
+            return n ? n - 1 : 0;
+        default:
+            return n;
+    }
+}
+
 /*
  * allringed: check if there is a ringed dot in every connected component
  * of a CoxeterGraph.
@@ -151,16 +163,16 @@ void ringnodes(CoxeterGraph& cg, const string& s) {
 
 /* Ring all the nodes in cg corresponding to set bits
  * in the unsigned integer b */
-void ringnodes(CoxeterGraph& cg, unsigned b) {
+void ringnodes(CoxeterGraph& cg, unsigned long long b) {
     vdesc v = 0;
-    vsize_t limit = std::numeric_limits<unsigned>::digits;
+    vsize_t limit = std::numeric_limits<unsigned long long>::digits;
     limit = std::min(limit, num_vertices(cg));
-    /* It would be nice to rely on left-shifting by more than 31 bits
+    /* It would be nice to rely on left-shifting by more than 63 bits
      * yielding 0, so that the below code would just work while v goes up
-     * to num_vertices(cg). Unfortunately, shifting by more than 31 bits
+     * to num_vertices(cg). Unfortunately, shifting by more than 63 bits
      * is undefined behavior by the standard. */
     for (; v < limit; ++v)
-        cg[v].ringed = (b & (1u << v)); // if bit v is set
+        cg[v].ringed = (b & (1ull << v)); // if bit v is set
     for (; v < num_vertices(cg); ++v)
         cg[v].ringed = false;
 }
@@ -179,43 +191,69 @@ string ringedlist(const CoxeterGraph& cg) {
     return s;
 }
 
-TeXout& operator<<(TeXout& tex, const CoxeterGraph& cg) {
-    static bool inited {false};
-
-    if (!inited) {
-        tex.usepackage("tikz");
-        tex.usetikzlibrary("quotes");
-        tex.addtopreamble("\\tikzset{\n"
-            "  dot/.style={fill,circle,inner sep=2pt,outer sep=0pt},\n"
-            "  dit/.style={fill,circle,inner sep=1.4pt,outer sep=0pt},\n"
-            "  ring/.style={draw,circle,inner sep=2.2pt}\n"
-            "}\n");
-        inited = true;
+namespace {
+    /* The tikz library and styles the drawings need, added to the preamble
+     * the first time */
+    void tikzsetup(TeXout& tex) {
+        static bool inited {false};
+
+        if (!inited) {
+            tex.usepackage("tikz");
+            tex.usetikzlibrary("quotes");
+            tex.addtopreamble("\\tikzset{\n"
+                "  dot/.style={fill,circle,inner sep=2pt,outer sep=0pt},\n"
+                "  dit/.style={fill,circle,inner sep=1.4pt,outer sep=0pt},\n"
+                "  ring/.style={draw,circle,inner sep=2.2pt}\n"
+                "}\n");
+            inited = true;
+        }
     }
 
-    for (unsigned v = 0; v < num_vertices(cg); ++v) {
-        tex << "\\node["
-            << (cg[v].ringed ? "dit" : "dot")
-            << "] (v" << v << ") at ("
-            << cg[v].x_coord << ", "
-            << cg[v].y_coord << ") {};\n";
-        if (cg[v].ringed) {
-            tex << "\\node[ring] at ("
+    /* Draw the nodes v of cg with keep(v), numbered 0, 1, ... in order,
+     * and the edges between them */
+    template <typename Keep>
+    TeXout& drawdiagram(TeXout& tex, const CoxeterGraph& cg, Keep keep) {
+        tikzsetup(tex);
+        std::vector<unsigned> name(num_vertices(cg));
+        unsigned kept = 0;
+        for (unsigned v = 0; v < num_vertices(cg); ++v) {
+            if (!keep(v))
+                continue;
+            name[v] = kept++;
+            tex << "\\node["
+                << (cg[v].ringed ? "dit" : "dot")
+                << "] (v" << name[v] << ") at ("
                 << cg[v].x_coord << ", "
                 << cg[v].y_coord << ") {};\n";
+            if (cg[v].ringed) {
+                tex << "\\node[ring] at ("
+                    << cg[v].x_coord << ", "
+                    << cg[v].y_coord << ") {};\n";
+            }
         }
+        bool any = false;
+        for (auto e : boost::make_iterator_range(boost::edges(cg))) {
+            const vdesc s = boost::source(e, cg), t = boost::target(e, cg);
+            if (!keep(s) || !keep(t))
+                continue;
+            if (!any)
+                tex << "\\draw";
+            any = true;
+            tex << "  (v" << name[s] << ") to";
+            if (cg[e].order == 0)
+                tex << "[\"\\infty\"]";
+            else if (cg[e].order != 3)
+                tex << "[\"" << cg[e].order << "\"]";
+            tex << " (v" << name[t] << ')';
+        }
+        return any ? tex << ";\n" : tex;
     }
-    auto edgits = boost::edges(cg);
-    if (edgits.first == edgits.second)
-        return tex;
-    tex << "\\draw";
-    for (auto eit = edgits.first; eit != edgits.second; ++eit) {
-        tex << "  (v" << boost::source(*eit, cg) << ") to";
-        if (cg[*eit].order == 0)
-            tex << "[\"\\infty\"]";
-        else if (cg[*eit].order != 3)
-            tex << "[\"" << cg[*eit].order << "\"]";
-        tex << " (v" << boost::target(*eit, cg) << ')';
-    }
-    return tex << ";\n";
+}
+
+TeXout& operator<<(TeXout& tex, const CoxeterGraph& cg) {
+    return drawdiagram(tex, cg, [](vdesc) { return true; });
+}
+
+TeXout& operator<<(TeXout& tex, const SubDiagram& sub) {
+    return drawdiagram(tex, sub.cg, [&sub](vdesc v) { return v < 64 && sub.mask >> v & 1u; });
 }
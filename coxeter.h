@@ -52,6 +52,13 @@ CoxeterGraph coxeterF4();
  * where it is the label of the unique edge. */
 CoxeterGraph coxeter_dispatch(char c, unsigned int n);
 
+/* For the families X = A, B, C, D, E, G, H (c as for coxeter_dispatch):
+ * X_{n+1} is X_n with one more node, put in at the index returned, with
+ * the nodes of X_n from there on numbered one higher. It's the last node
+ * for the linear diagrams, the first for D (whose fork is at the end),
+ * and the one before the leg for E. */
+vsize_t newnode(char c, vsize_t n);
+
 /* allringed: check if there is a ringed dot in every connected component
  * of a CoxeterGraph.  */
 bool allringed(const CoxeterGraph& cg);
@@ -61,9 +68,10 @@ bool allringed(const CoxeterGraph& cg);
  *   The length of the string s should be at most num_vertices(cg). */
 void ringnodes(CoxeterGraph& cg, const std::string& s);
 
-/*   Ring nodes corresponding to set bits in the unsigned integer b.
+/*   Ring nodes corresponding to set bits in the unsigned integer b
+ *   (at least 64 bits, so a nodemask fits).
  *   This only considers bits up to num_vertices(cg). */
-void ringnodes(CoxeterGraph& cg, unsigned b);
+void ringnodes(CoxeterGraph& cg, unsigned long long b);
 
 /* Return a string containing a comma-separated list of the ringed nodes
  * in cg. */
@@ -74,4 +82,15 @@ std::string ringedlist(const CoxeterGraph& cg);
  * given by tikz_preamble */
 TeXout& operator<<(TeXout& tex, const CoxeterGraph& cg);
 
+/* The subdiagram of cg on the nodes set in mask (as with ringnodes, at
+ * least 64 bits, so a nodemask fits), without a copy of it. It is drawn
+ * just as the subdiagram would be on its own, with its nodes numbered
+ * 0, 1, ... in order. */
+struct SubDiagram {
+    const CoxeterGraph& cg;
+    unsigned long long mask;
+};
+
+TeXout& operator<<(TeXout& tex, const SubDiagram& sub);
+
 #endif //COXETER_DIAGRAM_H
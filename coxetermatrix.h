@@ -0,0 +1,275 @@
+#ifndef NAM_COXETERMATRIX_H
+#define NAM_COXETERMATRIX_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <boost/range/iterator_range.hpp>
+#include "coxeter.h"
+#include "bitdiagram.h" // nodemask
+
+/*****************
+ * CoxeterMatrix *
+ *****************/
+
+/* A Coxeter diagram of at most N nodes as a plain value: its Coxeter
+ * matrix, a byte per pair of nodes, with the neighbours of each node and
+ * the ringed nodes as bitmasks. It is trivially copyable, holds no
+ * pointers, and everything about it is constexpr, so the diagrams of the
+ * catalogue below can be worked out at compile time. It takes N^2 + 8N
+ * bytes and a little more whatever the diagram's size: a few hundred for
+ * N = 16, but over 4 KB for N = 64, so the big ones are best passed by
+ * reference. Where the nodes are drawn is kept apart, in a
+ * DiagramPlaces.
+ * order(u, v) is the order of the product of the reflections u and v:
+ * 1 on the diagonal, 2 where there is no edge, and 0 for ∞, as on the
+ * edges of a CoxeterGraph. Orders above 255 can't be held. */
+template <vsize_t N>
+class CoxeterMatrix {
+    static_assert(N <= 64, "CoxeterMatrix: the neighbours must fit in a nodemask");
+
+    vsize_t n;
+    std::uint8_t orders[N][N];
+    nodemask adj[N]; // adj[v] is the set of neighbours of v
+    nodemask ring;
+
+    public:
+    static constexpr vsize_t maxnodes = N;
+
+    /* The empty diagram */
+    constexpr CoxeterMatrix() : n{0}, orders{}, adj{}, ring{0} {}
+
+    /* n nodes, unringed, with no edges.
+     * Throws std::length_error if n is more than N. */
+    explicit constexpr CoxeterMatrix(vsize_t n) : n{n}, orders{}, adj{}, ring{0} {
+        if (n > N)
+            throw std::length_error("CoxeterMatrix: too many nodes");
+        for (vsize_t u = 0; u < n; ++u) {
+            for (vsize_t v = 0; v < n; ++v)
+                orders[u][v] = u == v ? 1 : 2;
+        }
+    }
+
+    constexpr vsize_t size() const { return n; }
+    constexpr unsigned order(vsize_t u, vsize_t v) const { return orders[u][v]; }
+    constexpr nodemask neighbours(vsize_t v) const { return adj[v]; }
+    constexpr nodemask ringed() const { return ring; }
+
+    /* Give u and v (different nodes) an edge of order p, or take theirs
+     * away if p is 2. Throws std::out_of_range if u or v isn't a node, or
+     * std::invalid_argument if they are the same node or p is more than 255. */
+    constexpr void join(vsize_t u, vsize_t v, unsigned p) {
+        if (u >= n || v >= n)
+            throw std::out_of_range("CoxeterMatrix: no such node");
+        if (u == v)
+            throw std::invalid_argument("CoxeterMatrix: a node can't be joined to itself");
+        if (p > 255)
+            throw std::invalid_argument("CoxeterMatrix: edge order too big for a byte");
+        orders[u][v] = orders[v][u] = p;
+        if (p == 2) {
+            adj[u] &= ~(nodemask{1} << v);
+            adj[v] &= ~(nodemask{1} << u);
+        } else {
+            adj[u] |= nodemask{1} << v;
+            adj[v] |= nodemask{1} << u;
+        }
+    }
+
+    /* Ring the nodes in r (bits beyond the diagram are dropped) */
+    constexpr void setringed(nodemask r) {
+        ring = n == 64 ? r : r & ((nodemask{1} << n) - 1);
+    }
+
+    constexpr bool operator==(const CoxeterMatrix& m) const {
+        if (n != m.n || ring != m.ring)
+            return false;
+        for (vsize_t u = 0; u < n; ++u) {
+            for (vsize_t v = 0; v < n; ++v) {
+                if (orders[u][v] != m.orders[u][v])
+                    return false;
+            }
+        }
+        return true;
+    }
+    constexpr bool operator!=(const CoxeterMatrix& m) const { return !(*this == m); }
+};
+
+template <vsize_t N>
+constexpr vsize_t CoxeterMatrix<N>::maxnodes;
+
+/* Where the nodes of a diagram of at most N nodes are drawn */
+template <vsize_t N>
+struct DiagramPlaces {
+    int x[N];
+    int y[N];
+
+    constexpr DiagramPlaces() : x{}, y{} {}
+
+    constexpr bool operator==(const DiagramPlaces& p) const {
+        for (vsize_t v = 0; v < N; ++v) {
+            if (x[v] != p.x[v] || y[v] != p.y[v])
+                return false;
+        }
+        return true;
+    }
+};
+
+/*************
+ * Catalogue *
+ *************/
+
+/* The diagrams of coxeter_dispatch, with the same nodes, edges, and
+ * places: for c among A, B, C, D, E, F, G, H, the diagram X_n, and for I,
+ * I_2(n). Anything else (or F_n other than F_4) is the empty diagram.
+ * Throws std::length_error if it has more than N nodes. */
+template <vsize_t N>
+constexpr CoxeterMatrix<N> coxetermatrix(char c, unsigned n) {
+    unsigned p = 3; // the first edge of a linear diagram
+    switch (c) {
+        case 'A':
+            break;
+        case 'B':
+        case 'C':
+            p = 4;
+            break;
+        case 'D': {
+            CoxeterMatrix<N> m{n};
+            if (n < 3)
+                return m; // D_2 is a pair of unconnected nodes, A_1 × A_1
+            for (vsize_t i = 0; i < n - 2; ++i)
+                m.join(i, i + 1, 3);
+            m.join(n - 3, n - 1, 3);
+            return m;
+        }
+        case 'E': {
+            CoxeterMatrix<N> m{n};
+            for (vsize_t i = 0; i + 2 < n; ++i)
+                m.join(i, i + 1, 3);
+            if (n >= 4)
+                m.join(2, n - 1, 3);
+            return m;
+        }
+        case 'F': {
+            if (n != 4)
+                return {};
+            CoxeterMatrix<N> m{4};
+            m.join(0, 1, 3);
+            m.join(1, 2, 4);
+            m.join(2, 3, 3);
+            return m;
+        }
+        case 'G':
+            p = 6;
+            break;
+        case 'H':
+            p = 5;
+            break;
+        case 'I':
+            p = n;
+            n = 2;
+            break;
+        default:
+            return {};
+    }
+    CoxeterMatrix<N> m{n};
+    if (n < 2)
+        return m;
+    m.join(0, 1, p);
+    for (vsize_t i = 1; i + 1 < n; ++i)
+        m.join(i, i + 1, 3);
+    return m;
+}
+
+/* Where coxeter_dispatch puts the nodes of the same diagram */
+template <vsize_t N>
+constexpr DiagramPlaces<N> coxeterplaces(char c, unsigned n) {
+    DiagramPlaces<N> at;
+    const CoxeterMatrix<N> m = coxetermatrix<N>(c, n);
+    n = m.size();
+    if (n < 2)
+        return at;
+    if (c == 'D') {
+        at.x[n - 1] = at.x[n - 2] = n - 2;
+        at.y[n - 1] = 1;
+        at.y[n - 2] = -1;
+        for (vsize_t i = 0; i + 2 < n; ++i)
+            at.x[i] = i;
+    } else if (c == 'E') {
+        for (vsize_t i = 0; i < (n < 4 ? n : n - 1); ++i)
+            at.x[i] = i;
+        if (n >= 4) {
+            at.x[n - 1] = 2;
+            at.y[n - 1] = 1;
+        }
+    } else {
+        for (vsize_t i = 0; i < n; ++i)
+            at.x[i] = i;
+    }
+    return at;
+}
+
+/***************
+ * Conversions *
+ ***************/
+
+/* The matrix of cg. Loops are ignored.
+ * Throws std::length_error if cg has more than N nodes, or
+ * std::invalid_argument if it has an edge of order more than 255. */
+template <vsize_t N>
+CoxeterMatrix<N> tomatrix(const CoxeterGraph& cg) {
+    CoxeterMatrix<N> m{boost::num_vertices(cg)};
+    for (auto e : boost::make_iterator_range(boost::edges(cg))) {
+        const vsize_t s = boost::source(e, cg), t = boost::target(e, cg);
+        if (s != t)
+            m.join(s, t, cg[e].order);
+    }
+    nodemask r = 0;
+    for (vsize_t v = 0; v < boost::num_vertices(cg); ++v) {
+        if (cg[v].ringed)
+            r |= nodebit(v);
+    }
+    m.setringed(r);
+    return m;
+}
+
+/* Where the nodes of cg are.
+ * Throws std::length_error if cg has more than N nodes. */
+template <vsize_t N>
+DiagramPlaces<N> places(const CoxeterGraph& cg) {
+    if (boost::num_vertices(cg) > N)
+        throw std::length_error("DiagramPlaces: too many nodes");
+    DiagramPlaces<N> at;
+    for (vsize_t v = 0; v < boost::num_vertices(cg); ++v) {
+        at.x[v] = cg[v].x_coord;
+        at.y[v] = cg[v].y_coord;
+    }
+    return at;
+}
+
+/* The CoxeterGraph of m, with its nodes at the places given.
+ * The edges are added row by row of the matrix. */
+template <vsize_t N>
+CoxeterGraph tograph(const CoxeterMatrix<N>& m, const DiagramPlaces<N>& at) {
+    CoxeterGraph cg{m.size()};
+    for (vsize_t u = 0; u < m.size(); ++u) {
+        cg[u] = {bool(m.ringed() & nodebit(u)), at.x[u], at.y[u]};
+        const nodemask upto = nodebit(u) | (nodebit(u) - 1); // u and the nodes before it
+        for (nodemask later = m.neighbours(u) & ~upto; later; later &= later - 1)
+            boost::add_edge(u, lownode(later), {m.order(u, lownode(later))}, cg);
+    }
+    return cg;
+}
+
+/* The same, with node v at (v, 0) */
+template <vsize_t N>
+CoxeterGraph tograph(const CoxeterMatrix<N>& m) {
+    DiagramPlaces<N> at;
+    for (vsize_t v = 0; v < m.size(); ++v)
+        at.x[v] = v;
+    return tograph(m, at);
+}
+
+static_assert(std::is_trivially_copyable<CoxeterMatrix<16>>::value,
+              "CoxeterMatrix should be a plain value");
+
+#endif // NAM_COXETERMATRIX_H
@@ -0,0 +1,38 @@
+#include "facetable.h"
+#include <stdexcept>
+
+using boost::num_vertices;
+
+constexpr vsize_t FaceTable::maxnodes;
+
+FaceTable::FaceTable(const CoxeterGraph& cg) : n{0}, first{0, 0} {
+    // the empty set has no components
+    if (num_vertices(cg) > maxnodes)
+        throw std::length_error("FaceTable: too many nodes for a table of all subsets");
+    const BitDiagram bd{cg};
+    first.reserve((std::size_t{1} << num_vertices(cg)) + 1);
+    for (vsize_t v = 0; v < num_vertices(cg); ++v)
+        addnode(bd.neighbours(v));
+}
+
+void FaceTable::addnode(nodemask neighbours) {
+    if (n == maxnodes)
+        throw std::length_error("FaceTable: too many nodes for a table of all subsets");
+    // The components of s are those of s without its top node v,
+    // with the ones next to v merged together with v.
+    const vsize_t v = n++;
+    const std::uint32_t count = std::uint32_t{1} << n;
+    for (std::uint32_t s = nodebit(v); s < count; ++s) {
+        const nodemask rest = s & ~nodebit(v);
+        nodemask merged = nodebit(v);
+        for (std::uint32_t i = first[rest]; i < first[rest + 1]; ++i) {
+            const nodemask c = comps[i]; // copy: push_back may reallocate
+            if (c & neighbours)
+                merged |= c;
+            else
+                comps.push_back(c);
+        }
+        comps.push_back(merged);
+        first.push_back(comps.size());
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef NAM_FACETABLE_H
+#define NAM_FACETABLE_H
+
+#include <cstdint>
+#include <vector>
+#include <boost/range/iterator_range.hpp>
+#include "coxeter.h"
+#include "bitdiagram.h"
+
+/*************
+ * FaceTable *
+ *************/
+
+/* The connected components of every subdiagram of a Coxeter diagram.
+ * These depend only on the shape of the diagram, not on which nodes are
+ * ringed, so one table serves every ringing: under a ringing R, a subset S
+ * is a face exactly when each of its components meets R, which is a few
+ * word operations with no flooding. IntervalCache asks it about the faces
+ * under each ringing in turn, and RingingWalk about just the sets a toggle
+ * can change.
+ * The table has 2^n entries, so only diagrams with at most maxnodes nodes
+ * can have one. */
+class FaceTable {
+    vsize_t n;
+    std::vector<std::uint32_t> first; // components of s are comps[first[s]], ... before first[s+1]
+    std::vector<nodemask> comps;
+
+    public:
+    static constexpr vsize_t maxnodes = 20;
+
+    /* Throws std::length_error if cg has more than maxnodes nodes */
+    explicit FaceTable(const CoxeterGraph& cg);
+
+    /* Add node n (the new top node), joined to the nodes in neighbours.
+     * Only the 2^n sets containing it are worked out; the table is then
+     * the one for the bigger diagram.
+     * Throws std::length_error if there are maxnodes nodes already. */
+    void addnode(nodemask neighbours);
+
+    vsize_t size() const { return n; }
+
+    /* The connected components of the subdiagram on s */
+    boost::iterator_range<const nodemask*> components(nodemask s) const {
+        return {comps.data() + first[s], comps.data() + first[s + 1]};
+    }
+
+    /* Is s a face when the ringed nodes are ring? */
+    bool isface(nodemask s, nodemask ring) const {
+        for (auto c : components(s)) {
+            if (!(c & ring))
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif // NAM_FACETABLE_H
@@ -0,0 +1,94 @@
+#include "flagvector.h"
+#include <algorithm> // lower_bound, sort
+#include <cstdint>
+#include <stdexcept>
+
+using std::vector;
+using std::size_t;
+typedef HasseDiagram::nodeid nodeid;
+
+namespace { // this-file-only (internal linkage)
+    /* The faces below each face of hd, and the chain counts worked out
+     * from them */
+    class FlagCounter {
+        const HasseDiagram& hd;
+        unsigned n; // the ranks below the head
+        vector<std::uint64_t> start; // node i's faces below are below[start[i]],
+        vector<nodeid> below;        // ... before below[start[i+1]], in order
+        vector<Count128> flags;
+
+        /* Record the chains with ranks set, whose top is at rank m, with
+         * v[i] of them ending at each face rankbegin(m) + i, and go on to
+         * those with a face of a higher rank put on top */
+        void extend(unsigned m, std::uint32_t set, const vector<Count128>& v);
+
+        public:
+        explicit FlagCounter(const HasseDiagram& hd);
+        vector<Count128> flagvector();
+    };
+
+    FlagCounter::FlagCounter(const HasseDiagram& hd) : hd(hd), n{hd.rank(hd.head())} {
+        // a face's faces below are its children and theirs; the children
+        // come first in the order of ids, so theirs are known already
+        const nodeid none = ~nodeid{0};
+        vector<nodeid> seen(hd.size(), none); // seen[x] is i once x is below i
+        start.push_back(0);
+        for (nodeid i = 0; i < hd.size(); ++i) {
+            for (auto kid : hd.children(i)) {
+                if (seen[kid] != i) {
+                    seen[kid] = i;
+                    below.push_back(kid);
+                }
+                for (auto k = start[kid]; k < start[kid + 1]; ++k) {
+                    if (seen[below[k]] != i) {
+                        seen[below[k]] = i;
+                        below.push_back(below[k]);
+                    }
+                }
+            }
+            std::sort(below.begin() + start.back(), below.end());
+            start.push_back(below.size());
+        }
+    }
+
+    void FlagCounter::extend(unsigned m, std::uint32_t set, const vector<Count128>& v) {
+        for (auto c : v)
+            flags[set] += c;
+        const nodeid lo = hd.rankbegin(m), hi = hd.rankend(m);
+        for (unsigned up = m + 1; up < n; ++up) {
+            vector<Count128> w(hd.rankend(up) - hd.rankbegin(up));
+            for (nodeid y = hd.rankbegin(up); y < hd.rankend(up); ++y) {
+                // the faces below y of rank m are one run
+                const nodeid* first = below.data() + start[y];
+                const nodeid* last = below.data() + start[y + 1];
+                first = std::lower_bound(first, last, lo);
+                last = std::lower_bound(first, last, hi);
+                Count128& sum = w[y - hd.rankbegin(up)];
+                for (; first != last; ++first)
+                    sum += v[*first - lo];
+            }
+            extend(up, set | std::uint32_t{1} << up, w);
+        }
+    }
+
+    vector<Count128> FlagCounter::flagvector() {
+        flags.assign(std::size_t{1} << n, 0);
+        flags[0] = 1; // the empty chain
+        for (unsigned m = 0; m < n; ++m)
+            extend(m, std::uint32_t{1} << m, vector<Count128>(hd.rankend(m) - hd.rankbegin(m), 1));
+        return std::move(flags);
+    }
+}
+
+vector<size_t> fvector(const HasseDiagram& hd) {
+    vector<size_t> f;
+    for (unsigned r = 0; r < hd.rank(hd.head()); ++r)
+        f.push_back(hd.rankend(r) - hd.rankbegin(r));
+    return f;
+}
+
+vector<Count128> flagvector(const HasseDiagram& hd) {
+    if (hd.rank(hd.head()) > maxflagranks)
+        throw std::length_error("flagvector: too many ranks");
+    return FlagCounter{hd}.flagvector();
+}
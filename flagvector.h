@@ -0,0 +1,39 @@
+#ifndef NAM_FLAGVECTOR_H
+#define NAM_FLAGVECTOR_H
+
+#include <cstddef>
+#include <vector>
+#include "hassediagram.h"
+#include "count128.h"
+
+/****************
+ * Flag vectors *
+ ****************/
+
+/* Counts of the face orbits of a HasseDiagram by rank, and of its chains
+ * by the set of ranks they meet. Only the ranks below the head (the
+ * proper faces) are counted, so for a diagram of n nodes these are ranks
+ * 0 to n - 1.
+ *
+ * A chain x_1 < x_2 < ... < x_k need not be saturated: x_i is any face
+ * below x_{i+1}. Each node's faces below it are found once, a run of ids
+ * per rank; then the chains with ranks S + {s} ending at each face of
+ * rank s come from those with ranks S by one sum over those runs. The
+ * rank sets are gone through depth first, so only one vector per rank is
+ * held at a time. */
+
+/* Entry r is the number of face orbits of rank r */
+std::vector<std::size_t> fvector(const HasseDiagram& hd);
+
+/* The flag f-vector: entry S, taken as a set of ranks (bit r for rank r),
+ * is the number of chains of face orbits whose ranks are just those in S.
+ * So entry 0 is 1 (the empty chain), entry 1 << r is fvector(hd)[r], and
+ * when some node is ringed, the last entry is the number of flag orbits,
+ * hd.numpaths()[hd.head()].
+ * Throws std::length_error if the head is above rank maxflagranks, as
+ * there would be too many entries. */
+std::vector<Count128> flagvector(const HasseDiagram& hd);
+
+constexpr unsigned maxflagranks = 24;
+
+#endif // NAM_FLAGVECTOR_H
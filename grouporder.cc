@@ -0,0 +1,159 @@
+#include "grouporder.h"
+#include <algorithm> // any_of, sort
+#include <stdexcept>
+#include <unordered_map>
+
+using std::vector;
+using boost::num_vertices;
+
+namespace { // this-file-only (internal linkage)
+    [[noreturn]] void infinite() {
+        throw std::domain_error("GroupOrder: the group is infinite");
+    }
+
+    Count128 factorial(unsigned k) {
+        Count128 f = 1;
+        for (unsigned i = 2; i <= k; ++i)
+            f *= i;
+        return f;
+    }
+
+    Count128 power2(unsigned k) {
+        Count128 p = 1;
+        for (unsigned i = 0; i < k; ++i)
+            p *= 2;
+        return p;
+    }
+}
+
+GroupOrder::GroupOrder(const CoxeterGraph& cg) : bd{cg} {
+    const vsize_t n = num_vertices(cg);
+    orders.assign(n*n, 2);
+    for (auto e : boost::make_iterator_range(edges(cg))) {
+        const vsize_t u = source(e, cg), v = target(e, cg);
+        orders[u*n + v] = orders[v*n + u] = cg[e].order;
+    }
+}
+
+Count128 GroupOrder::irreducible(nodemask c) const {
+    const vsize_t n = bd.size(), k = __builtin_popcountll(c);
+    // a tree, with at most one node of three branches and none of more,
+    // and no ∞ edge
+    vsize_t end = n, branch = n, degrees = 0;
+    for (nodemask rest = c; rest; rest &= rest - 1) {
+        const vsize_t v = lownode(rest);
+        const nodemask nbrs = bd.neighbours(v) & c;
+        const vsize_t degree = __builtin_popcountll(nbrs);
+        for (nodemask w = nbrs; w; w &= w - 1) {
+            if (orders[v*n + lownode(w)] == 0)
+                infinite();
+        }
+        if (degree > 3 || (degree == 3 && branch != n))
+            infinite();
+        if (degree == 3)
+            branch = v;
+        if (degree <= 1 && end == n)
+            end = v;
+        degrees += degree;
+    }
+    if (degrees != 2*(k - 1))
+        infinite(); // there is a cycle
+    // the edge orders going on from v, away from prev, until the end of
+    // the path or the branch
+    auto along = [&](vsize_t prev, vsize_t v) {
+        vector<unsigned> met;
+        for (;;) {
+            const nodemask on = bd.neighbours(v) & c & ~(prev == n ? 0 : nodebit(prev));
+            if (on == 0 || (on & (on - 1)))
+                return met;
+            met.push_back(orders[v*n + lownode(on)]);
+            prev = v;
+            v = lownode(on);
+        }
+    };
+
+    if (branch != n) { // D_k or E_k: all the edges of order 3
+        vector<vsize_t> legs;
+        for (nodemask w = bd.neighbours(branch) & c; w; w &= w - 1) {
+            const vector<unsigned> leg = along(branch, lownode(w));
+            if (orders[branch*n + lownode(w)] != 3
+                    || std::any_of(leg.begin(), leg.end(), [](unsigned p) { return p != 3; }))
+                infinite();
+            legs.push_back(leg.size() + 1);
+        }
+        std::sort(legs.begin(), legs.end());
+        if (legs[0] == 1 && legs[1] == 1)
+            return power2(k - 1)*factorial(k); // D_k
+        if (legs[0] == 1 && legs[1] == 2 && legs[2] <= 4)
+            return legs[2] == 2 ? 51840 : legs[2] == 3 ? 2903040 : 696729600; // E_6, E_7, E_8
+        infinite();
+    }
+
+    const vector<unsigned> path = along(n, end);
+    if (k == 1)
+        return 2; // A_1
+    if (k == 2)
+        return 2*Count128(path[0]); // I_2(p)
+    vsize_t odd = 0, at = 0; // edges not of order 3, and where the last one is
+    for (vsize_t i = 0; i < path.size(); ++i) {
+        if (path[i] != 3) {
+            ++odd;
+            at = i;
+        }
+    }
+    if (odd == 0)
+        return factorial(k + 1); // A_k
+    const bool atend = at == 0 || at == k - 2;
+    if (odd == 1 && path[at] == 4 && atend)
+        return power2(k)*factorial(k); // B_k
+    if (odd == 1 && path[at] == 4 && k == 4)
+        return 1152; // F_4
+    if (odd == 1 && path[at] == 5 && atend && k <= 4)
+        return k == 3 ? 120 : 14400; // H_3, H_4
+    infinite();
+}
+
+Count128 GroupOrder::order(nodemask s) const {
+    s &= bd.all();
+    Count128 product = 1;
+    for (nodemask rest = s; rest; ) {
+        const nodemask c = bd.component(s, lownode(rest));
+        product *= irreducible(c);
+        rest &= ~c;
+    }
+    return product;
+}
+
+nodemask GroupOrder::stabilizer(nodemask s) const {
+    nodemask near = s;
+    for (nodemask rest = s; rest; rest &= rest - 1)
+        near |= bd.neighbours(lownode(rest));
+    return s | (bd.all() & ~bd.ringed() & ~near);
+}
+
+vector<Count128> orbitsizes(const HasseDiagram& hd) {
+    const GroupOrder group{hd.diagram()};
+    vector<Count128> sizes;
+    sizes.reserve(hd.size());
+    for (HasseDiagram::nodeid i = 0; i < hd.size(); ++i)
+        sizes.push_back(group.orbitsize(hd.mask(i)));
+    return sizes;
+}
+
+vector<Count128> flagsizes(const HasseDiagram& hd) {
+    const GroupOrder group{hd.diagram()};
+    const Count128 whole = group.order();
+    // few sets of nodes ever stabilize a flag, so their orders are kept
+    std::unordered_map<nodemask, Count128> stable;
+    vector<Count128> sizes;
+    for (ChainEnumerator e{hd}; !e.done(); e.next()) {
+        nodemask fixed = ~nodemask{0};
+        for (auto i : e.current())
+            fixed &= group.stabilizer(hd.mask(i));
+        auto known = stable.find(fixed);
+        if (known == stable.end())
+            known = stable.emplace(fixed, group.order(fixed)).first;
+        sizes.push_back(whole/known->second);
+    }
+    return sizes;
+}
@@ -0,0 +1,65 @@
+#ifndef NAM_GROUPORDER_H
+#define NAM_GROUPORDER_H
+
+#include <vector>
+#include "coxeter.h"
+#include "bitdiagram.h"
+#include "hassediagram.h"
+#include "count128.h"
+
+/**************
+ * GroupOrder *
+ **************/
+
+/* The orders of the parabolic subgroups of a Coxeter group: W_S, for a set
+ * S of nodes, is generated by the reflections of the nodes in S, and is the
+ * product of the groups of its components. Each component must be one of
+ * the finite irreducible types, whose orders are known:
+ *   A_k  (k + 1)!          B_k  2^k k!          D_k  2^(k-1) k!
+ *   E_6  51840             E_7  2903040         E_8  696729600
+ *   F_4  1152              H_3  120             H_4  14400
+ *   I_2(p)  2p
+ * So the order is found from the shape of each component, with no
+ * enumeration of the group at all.
+ *
+ * These give the sizes of the orbits in the polytope itself. The face
+ * orbit with the nodes S is stabilized by W_S and by the unringed nodes
+ * away from S (neither in S nor next to it), so it has
+ * |W| / (|W_S| |W_T|) faces, with T those nodes. A flag orbit is
+ * stabilized by what stabilizes every face in it: the unringed nodes
+ * which, for each face, are in it or away from it. */
+class GroupOrder {
+    BitDiagram bd;
+    std::vector<unsigned> orders; // orders[u*n + v] for neighbours u and v
+
+    /* |W_c| for c connected */
+    Count128 irreducible(nodemask c) const;
+
+    public:
+    /* Throws std::length_error if cg has more than BitDiagram::maxnodes nodes */
+    explicit GroupOrder(const CoxeterGraph& cg);
+
+    /* |W_s|. Throws std::domain_error if it is infinite, or
+     * std::overflow_error if it doesn't fit in a Count128. */
+    Count128 order(nodemask s) const;
+
+    /* |W|, the whole group */
+    Count128 order() const { return order(bd.all()); }
+
+    /* The nodes whose reflections fix the face with the nodes in s:
+     * s and the unringed nodes away from it */
+    nodemask stabilizer(nodemask s) const;
+
+    /* The number of faces in the orbit of the face s, |W| / |W_stabilizer(s)| */
+    Count128 orbitsize(nodemask s) const { return order()/order(stabilizer(s)); }
+};
+
+/* The number of faces of the polytope in each face orbit of hd,
+ * indexed by id */
+std::vector<Count128> orbitsizes(const HasseDiagram& hd);
+
+/* The number of flags of the polytope in each flag orbit of hd,
+ * in the order ChainEnumerator lists them */
+std::vector<Count128> flagsizes(const HasseDiagram& hd);
+
+#endif // NAM_GROUPORDER_H
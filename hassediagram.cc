@@ -0,0 +1,340 @@
+#include "hassediagram.h"
+#include <algorithm>
+#include <array>
+#include <cmath> // log2
+#include <limits>
+#include "TeXout.h"
+
+using std::vector;
+using std::max;
+using boost::num_vertices;
+typedef CoxeterGraph::vertex_descriptor Vertex; // it's std::size_t
+typedef HasseDiagram::nodeid nodeid;
+
+namespace { // this-file-only (internal linkage)
+    /* Find the range of a (numeric) vertex property on a graph */
+    template <typename PropMap>
+    int proprange(const PropMap& p) {
+        auto vits = boost::vertices(*p.m_g);
+        auto mnmx = std::minmax_element(vits.first, vits.second,
+                [&p](Vertex a, Vertex b) {
+                    return get(p, a) < get(p, b);
+                });
+        return get(p, *mnmx.second) - get(p, *mnmx.first);
+    }
+
+    /* Name of the TikZ node for a face: its mask in hex,
+     * least significant digit first (wrong-endian) */
+    std::string nodename(nodemask m) {
+        static const char hex[] = "0123456789abcdef";
+        std::string name{"n"};
+        for (; m; m >>= 4)
+            name += hex[m & 15u];
+        return name;
+    }
+
+    /* The arrays of a HasseDiagram built in memory */
+    struct HasseArrays {
+        vector<nodemask> masks;
+        vector<nodeid> rankstart;
+        vector<std::uint32_t> downstart, upstart;
+        vector<nodeid> downs, ups;
+    };
+}
+
+HasseDiagram::HasseDiagram(CoxeterGraph cg, vector<nodemask> masks,
+                           vector<std::uint32_t> downstart, vector<nodeid> downs)
+  : cg(std::move(cg)) {
+    auto arr = std::make_shared<HasseArrays>();
+    arr->masks = std::move(masks);
+    arr->downstart = std::move(downstart);
+    arr->downs = std::move(downs);
+    const std::size_t n = arr->masks.size();
+    const auto rankof = [&](nodeid i) { return __builtin_popcountll(arr->masks[i]); };
+    arr->rankstart.assign(num_vertices(this->cg) + 2, n);
+    for (nodeid i = n; i-- > 0; )
+        arr->rankstart[rankof(i)] = i;
+    for (std::size_t r = arr->rankstart.size() - 1; r-- > 0; ) // ranks with no nodes
+        arr->rankstart[r] = std::min(arr->rankstart[r], arr->rankstart[r + 1]);
+    // Transpose: count each node's parents, then fill them in
+    // in increasing order of parent
+    arr->upstart.assign(n + 1, 0);
+    for (auto kid : arr->downs)
+        ++arr->upstart[kid + 1];
+    for (std::size_t i = 0; i < n; ++i)
+        arr->upstart[i + 1] += arr->upstart[i];
+    arr->ups.resize(arr->downs.size());
+    vector<std::uint32_t> fill(arr->upstart.begin(), arr->upstart.end() - 1);
+    for (nodeid p = 0; p < n; ++p) {
+        for (auto d = arr->downstart[p]; d < arr->downstart[p + 1]; ++d)
+            arr->ups[fill[arr->downs[d]]++] = p;
+    }
+    at = {n, arr->rankstart.size() - 1, arr->downs.size(), arr->masks.data(),
+          arr->rankstart.data(), arr->downstart.data(), arr->upstart.data(),
+          arr->downs.data(), arr->ups.data()};
+    store = std::move(arr);
+}
+
+vector<Count128> HasseDiagram::numpaths() const {
+    // ids go up by rank, so each node's children are counted before it
+    vector<Count128> paths(size());
+    for (nodeid i = 0; i < size(); ++i) {
+        if (children(i).empty()) {
+            paths[i] = 1;
+            continue;
+        }
+        for (auto kid : children(i))
+            paths[i] += paths[kid];
+    }
+    return paths;
+}
+
+vector<vector<nodeid>> HasseDiagram::rankorder(unsigned sweeps) const {
+    /* Where to put the nodes of a rank, left to right: by the average of
+     * the x-coordinates of the dots in the subdiagram, then those of the
+     * parents and children, then the leftmost parent and child, and then
+     * the first dot. */
+    vector<double> x_avg(size());
+    for (nodeid i = 0; i < size(); ++i) {
+        double sum = 0.0;
+        for (nodemask rest = mask(i); rest; rest &= rest - 1)
+            sum += cg[lownode(rest)].x_coord;
+        x_avg[i] = sum/rank(i);
+    }
+    vector<std::array<double,6>> key(size());
+    for (nodeid i = 0; i < size(); ++i) {
+        double up = 0.0, down = 0.0;
+        double minup = std::numeric_limits<double>::infinity(), mindown = minup;
+        for (auto p : parents(i)) {
+            up += x_avg[p];
+            minup = std::min(minup, x_avg[p]);
+        }
+        for (auto k : children(i)) {
+            down += x_avg[k];
+            mindown = std::min(mindown, x_avg[k]);
+        }
+        key[i] = {x_avg[i], up/parents(i).size(), down/children(i).size(),
+            minup, mindown,
+            mask(i) ? static_cast<double>(cg[lownode(mask(i))].x_coord) : 0.0};
+    }
+    vector<vector<nodeid>> order(numranks());
+    for (unsigned y = 0; y < numranks(); ++y) {
+        order[y].resize(rankend(y) - rankbegin(y));
+        for (nodeid i = rankbegin(y); i < rankend(y); ++i)
+            order[y][i - rankbegin(y)] = i;
+        std::sort(order[y].begin(), order[y].end(),
+                  [&key](nodeid a, nodeid b) { return key[a] < key[b]; });
+    }
+    if (sweeps == 0 || numranks() < 2)
+        return order;
+
+    // pos[i] is where node i is in its rank; bary is the average of its
+    // neighbours' on the side just done, or its own if it has none there
+    vector<double> pos(size()), bary(size());
+    auto place = [&](unsigned y) {
+        for (std::size_t k = 0; k < order[y].size(); ++k)
+            pos[order[y][k]] = k;
+    };
+    auto reorder = [&](unsigned y, bool fromabove) {
+        for (auto i : order[y]) {
+            const idrange near = fromabove ? parents(i) : children(i);
+            double sum = 0.0;
+            for (auto j : near)
+                sum += pos[j];
+            bary[i] = near.empty() ? pos[i] : sum/near.size();
+        }
+        std::stable_sort(order[y].begin(), order[y].end(),
+                         [&bary](nodeid a, nodeid b) { return bary[a] < bary[b]; });
+        place(y);
+    };
+    for (unsigned y = 0; y < numranks(); ++y)
+        place(y);
+    vector<vector<nodeid>> best = order;
+    std::uint64_t fewest = crossings(order);
+    for (unsigned pass = 0; pass < sweeps && fewest > 0; ++pass) {
+        if (pass % 2 == 0) {
+            for (unsigned y = numranks() - 1; y-- > 0; )
+                reorder(y, true);
+        } else {
+            for (unsigned y = 1; y < numranks(); ++y)
+                reorder(y, false);
+        }
+        const std::uint64_t now = crossings(order);
+        if (now < fewest) {
+            fewest = now;
+            best = order;
+        }
+    }
+    return best;
+}
+
+std::uint64_t HasseDiagram::crossings(const vector<vector<nodeid>>& order) const {
+    // Between ranks y and y + 1, list the links by their lower end's place,
+    // then their upper end's; two cross when their upper ends come in the
+    // other order, which a Fenwick tree over the upper places counts.
+    vector<std::uint32_t> pos(size());
+    for (const auto& rank : order) {
+        for (std::size_t k = 0; k < rank.size(); ++k)
+            pos[rank[k]] = k;
+    }
+    std::uint64_t total = 0;
+    vector<std::uint32_t> uppers, tree;
+    for (std::size_t y = 0; y + 1 < order.size(); ++y) {
+        uppers.clear();
+        for (auto i : order[y]) {
+            const std::size_t first = uppers.size();
+            for (auto p : parents(i))
+                uppers.push_back(pos[p]);
+            std::sort(uppers.begin() + first, uppers.end());
+        }
+        const std::size_t width = order[y + 1].size();
+        tree.assign(width + 1, 0);
+        for (std::size_t k = 0; k < uppers.size(); ++k) {
+            // the links before this one with their upper end to its right
+            std::uint64_t notright = 0;
+            for (std::size_t t = uppers[k] + 1; t > 0; t &= t - 1)
+                notright += tree[t];
+            total += k - notright;
+            for (std::size_t t = uppers[k] + 1; t <= width; t += t & -t)
+                ++tree[t];
+        }
+    }
+    return total;
+}
+
+void HasseDiagram::to_tikz(TeXout& tex, unsigned sweeps) const {
+    const double width = proprange(get(&VertexProps::x_coord, cg));
+    const double height = proprange(get(&VertexProps::y_coord, cg));
+    // separation between the nodes:
+    const double sep = width < 2.0 ? 1.0 : 1.5;
+    const double yscale = max(height + 0.5, std::log2(max(2.0, width)));
+
+    const auto order = rankorder(sweeps);
+    for (int y = numranks() - 1; y >= 0; --y) {
+        const int num = order[y].size();
+        for (int i = 0; i < num; ++i) {
+            const nodeid id = order[y][i];
+            const double xpos = (width + sep)*(i - (num - 1)/2.0);
+            tex << "\\node[draw] (" << nodename(mask(id))
+                << ") at (" << xpos
+                << ", " << y*yscale << ") {\n"
+                << env_wrap{"tikzpicture"} << SubDiagram{cg, mask(id)}
+                << "};\n";
+            for (auto p : parents(id)) {
+                tex << "\\draw (" << nodename(mask(p)) << ") -- ("
+                    << nodename(mask(id)) << ");\n";
+            }
+        }
+    }
+}
+
+/*******************
+ * ChainEnumerator *
+ *******************/
+
+ChainEnumerator::ChainEnumerator(const HasseDiagram& hd) :
+  hd{&hd}, paths{std::make_shared<const vector<Count128>>(hd.numpaths())} {
+    seek(0);
+}
+
+void ChainEnumerator::descend() {
+    for (auto kids = hd->children(path.back()); !kids.empty(); kids = hd->children(path.back())) {
+        pick.push_back(0);
+        path.push_back(kids.front());
+    }
+    chain.assign(path.rbegin(), path.rend());
+}
+
+void ChainEnumerator::next() {
+    pos += 1;
+    // the deepest node on the path with another child to try
+    for (std::size_t d = pick.size(); d-- > 0; ) {
+        const auto kids = hd->children(path[d]);
+        if (pick[d] + 1 < kids.size()) {
+            path.resize(d + 1);
+            pick.resize(d + 1);
+            ++pick[d];
+            path.push_back(kids[pick[d]]);
+            descend();
+            return;
+        }
+    }
+    path.clear();
+    pick.clear();
+}
+
+void ChainEnumerator::seek(Count128 k) {
+    path.clear();
+    pick.clear();
+    pos = k;
+    if (!(k < size()))
+        return; // done
+    // Go down, skipping the children whose chains all come before k;
+    // skipped counts the chains passed over so far.
+    Count128 skipped = 0;
+    path.push_back(hd->head());
+    for (auto kids = hd->children(path.back()); !kids.empty(); kids = hd->children(path.back())) {
+        std::uint32_t c = 0;
+        while (!(k < skipped + (*paths)[kids[c]])) {
+            skipped += (*paths)[kids[c]];
+            ++c;
+        }
+        pick.push_back(c);
+        path.push_back(kids[c]);
+    }
+    chain.assign(path.rbegin(), path.rend());
+}
+
+/****************
+ * ChainRanking *
+ ****************/
+
+ChainRanking::ChainRanking(const HasseDiagram& hd) : hd{&hd} {
+    const auto paths = hd.numpaths();
+    total = paths[hd.head()];
+    downstart.assign(1, 0);
+    upstart.assign(1, 0);
+    for (nodeid i = 0; i < hd.size(); ++i) {
+        Count128 before = 0;
+        for (auto kid : hd.children(i)) {
+            downlabel.push_back(before);
+            before += paths[kid];
+        }
+        downstart.push_back(downlabel.size());
+        upstart.push_back(upstart.back() + hd.parents(i).size());
+    }
+    // parents() is in increasing order, and so is this, so each link
+    // lands in its place among the child's parents.
+    uplabel.resize(downlabel.size());
+    vector<std::uint32_t> fill(upstart.begin(), upstart.end() - 1);
+    for (nodeid i = 0; i < hd.size(); ++i) {
+        std::uint32_t e = downstart[i];
+        for (auto kid : hd.children(i))
+            uplabel[fill[kid]++] = downlabel[e++];
+    }
+}
+
+Count128 ChainRanking::rank(const vector<nodeid>& chain) const {
+    Count128 k = 0;
+    for (std::size_t d = 0; d + 1 < chain.size(); ++d) {
+        const auto ups = hd->parents(chain[d]);
+        const auto at = std::lower_bound(ups.begin(), ups.end(), chain[d + 1]);
+        k += uplabel[upstart[chain[d]] + (at - ups.begin())];
+    }
+    return k;
+}
+
+void ChainRanking::unrank(Count128 k, vector<nodeid>& chain) const {
+    chain.clear();
+    nodeid i = hd->head();
+    chain.push_back(i);
+    while (downstart[i] != downstart[i + 1]) {
+        // the last child whose label is at most k
+        const auto first = downlabel.begin() + downstart[i], last = downlabel.begin() + downstart[i + 1];
+        const auto c = std::upper_bound(first, last, k) - first - 1;
+        k -= first[c];
+        i = hd->children(i)[c];
+        chain.push_back(i);
+    }
+    std::reverse(chain.begin(), chain.end());
+}
@@ -0,0 +1,192 @@
+#ifndef NAM_HASSEDIAGRAM_H
+#define NAM_HASSEDIAGRAM_H
+
+#include <cstdint>
+#include <memory> // shared_ptr
+#include <vector>
+#include <boost/range/iterator_range.hpp>
+#include "coxeter.h" // includes <boost/graph/adjacency_list.hpp> and forward-declares TeXout
+#include "bitdiagram.h" // nodemask
+#include "count128.h"
+
+/****************
+ * HasseDiagram *
+ ****************/
+
+/* A finished poset of face orbits, frozen into compressed sparse rows.
+ * The nodes are numbered 0, 1, 2, ... by rank, and by mask within a rank,
+ * so the empty face is 0 and the head is size() - 1; since a face's rank is
+ * its number of nodes, rank r is ids rankbegin(r) up to rankend(r).
+ * Each node's children are a contiguous run of ids in one array, and its
+ * parents a run in another, so traversals walk flat arrays, and anything
+ * else to be known per node can be kept in a vector indexed by id.
+ * Children are in the order they were found (dropping nodes in increasing
+ * order), and parents in increasing order.
+ * This is what the analysis passes (path counts, chains, drawing, orbit
+ * graphs) work from; see FaceOrbitPoset::freeze. */
+class HasseDiagram {
+    public:
+    typedef std::uint32_t nodeid;
+    typedef boost::iterator_range<const nodeid*> idrange;
+
+    /* Where the arrays are, and how long: masks has size entries,
+     * downstart and upstart size + 1 (the last is the end), rankstart
+     * numranks + 1 (rank r is [rankstart[r], rankstart[r+1])), and downs
+     * and ups numedges. */
+    struct Layout {
+        std::size_t size, numranks, numedges;
+        const nodemask* masks;
+        const nodeid* rankstart;
+        const std::uint32_t* downstart;
+        const std::uint32_t* upstart;
+        const nodeid* downs;
+        const nodeid* ups;
+    };
+
+    private:
+    CoxeterGraph cg; // the whole diagram, for drawing
+    Layout at;
+    std::shared_ptr<const void> store; // holds the arrays: vectors, or a mapped file
+
+    public:
+    HasseDiagram() : at{0, 0, 0, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr} {}
+
+    /* From the diagram, the masks in order, and the children of each node:
+     * those of node i are downs[downstart[i]] ... before downs[downstart[i+1]].
+     * The parents are worked out from the children. */
+    HasseDiagram(CoxeterGraph cg, std::vector<nodemask> masks,
+                 std::vector<std::uint32_t> downstart, std::vector<nodeid> downs);
+
+    /* Over arrays kept elsewhere (such as a file in memory, see orbitcache.h),
+     * which store keeps alive; nothing is copied */
+    HasseDiagram(CoxeterGraph cg, const Layout& layout, std::shared_ptr<const void> store)
+      : cg(std::move(cg)), at(layout), store(std::move(store)) {}
+
+    const CoxeterGraph& diagram() const { return cg; }
+    const Layout& layout() const { return at; }
+    std::size_t size() const { return at.size; }
+    std::size_t numedges() const { return at.numedges; }
+    unsigned numranks() const { return at.numranks; }
+    nodeid head() const { return at.size - 1; }
+
+    nodemask mask(nodeid i) const { return at.masks[i]; }
+    unsigned rank(nodeid i) const { return __builtin_popcountll(at.masks[i]); }
+    nodeid rankbegin(unsigned r) const { return at.rankstart[r]; }
+    nodeid rankend(unsigned r) const { return at.rankstart[r + 1]; }
+
+    idrange children(nodeid i) const {
+        return {at.downs + at.downstart[i], at.downs + at.downstart[i + 1]};
+    }
+    idrange parents(nodeid i) const {
+        return {at.ups + at.upstart[i], at.ups + at.upstart[i + 1]};
+    }
+
+    /* The number of paths down from each node, indexed by id */
+    std::vector<Count128> numpaths() const;
+
+    /* The order to draw each rank in, left to right (indexed by rank).
+     * Each node's place is found once, from the x-coordinates of its
+     * dots and of its parents' and children's (see to_tikz); then if
+     * sweeps is more than 0, that many passes of the barycenter heuristic
+     * go down and up the ranks in turn, moving each node toward the middle
+     * of its neighbours in the rank just done. Whichever order had the
+     * fewest crossings is returned. */
+    std::vector<std::vector<nodeid>> rankorder(unsigned sweeps = 0) const;
+
+    /* The number of pairs of links which cross when the ranks are drawn
+     * in order */
+    std::uint64_t crossings(const std::vector<std::vector<nodeid>>& order) const;
+
+    /* Draw the poset, each face as its subdiagram, in the order
+     * rankorder(sweeps) */
+    void to_tikz(TeXout& tex, unsigned sweeps = 0) const;
+};
+
+inline TeXout& operator<<(TeXout& tex, const HasseDiagram& hd) {
+    hd.to_tikz(tex);
+    return tex;
+}
+
+/*******************
+ * ChainEnumerator *
+ *******************/
+
+/* The maximal chains from the head down (the flag orbits), one at a time.
+ * Each chain is listed bottom to top, in a buffer which is reused, and the
+ * chains come in depth-first order, following the children in order.
+ * Chains are numbered from 0 in that order, and seek(k) jumps straight to
+ * chain k by skipping whole subtrees, using the path counts below each node.
+ * Copies are cheap (the path counts are shared), so one enumerator can be
+ * copied to start another part way through.
+ * The HasseDiagram must outlive the enumerator. */
+class ChainEnumerator {
+    typedef HasseDiagram::nodeid nodeid;
+
+    const HasseDiagram* hd;
+    std::shared_ptr<const std::vector<Count128>> paths;
+    std::vector<nodeid> path; // the current chain, from the head down
+    std::vector<std::uint32_t> pick; // path[d+1] is child pick[d] of path[d]
+    std::vector<nodeid> chain; // the current chain, bottom to top
+    Count128 pos;
+
+    /* Go down from the end of path to the bottom, by first children */
+    void descend();
+
+    public:
+    /* Starting at chain 0 */
+    explicit ChainEnumerator(const HasseDiagram& hd);
+
+    /* Are all the chains done? */
+    bool done() const { return path.empty(); }
+
+    /* The current chain, bottom to top. Not valid once done. */
+    const std::vector<nodeid>& current() const { return chain; }
+
+    /* The number of the current chain */
+    Count128 position() const { return pos; }
+
+    /* The number of chains altogether */
+    Count128 size() const { return (*paths)[hd->head()]; }
+
+    /* Move on to the next chain */
+    void next();
+
+    /* Move to chain k (any k: past the end is done) */
+    void seek(Count128 k);
+};
+
+/****************
+ * ChainRanking *
+ ****************/
+
+/* A bijection between the maximal chains and the integers 0, 1, ... size()-1,
+ * numbering the chains in the order ChainEnumerator gives them.
+ * Every link from a node to one of its children is labeled by the number
+ * of chains through the earlier children; a chain's number is the sum of
+ * the labels along it. So rank() and unrank() take a binary search per rank
+ * (over a node's parents, or over its children's labels, which increase),
+ * and neither one enumerates anything.
+ * The HasseDiagram must outlive the ranking. */
+class ChainRanking {
+    typedef HasseDiagram::nodeid nodeid;
+
+    const HasseDiagram* hd;
+    std::vector<std::uint32_t> downstart, upstart; // as in HasseDiagram
+    std::vector<Count128> downlabel; // by link, in the order of children()
+    std::vector<Count128> uplabel; // the same labels, in the order of parents()
+    Count128 total;
+
+    public:
+    explicit ChainRanking(const HasseDiagram& hd);
+
+    /* The number of chains */
+    Count128 size() const { return total; }
+
+    /* The number of a chain, listed bottom to top. It must be a maximal chain. */
+    Count128 rank(const std::vector<nodeid>& chain) const;
+
+    /* Chain number k, bottom to top, into chain. k must be less than size() */
+    void unrank(Count128 k, std::vector<nodeid>& chain) const;
+};
+
+#endif // NAM_HASSEDIAGRAM_H
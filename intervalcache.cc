@@ -0,0 +1,202 @@
+#include "intervalcache.h"
+#include <algorithm> // sort
+#include <vector>
+
+using std::string;
+using std::to_string;
+using std::vector;
+using boost::num_vertices;
+
+/* Connectivity and rings as bitmasks, plus the edge orders,
+ * and the diagram's FaceTable if there is one */
+template <typename Mask>
+struct IntervalCache::Shape {
+    typedef MaskBits<Mask> B;
+    BasicBitDiagram<Mask> bd;
+    vector<unsigned> orders; // orders[u*n + v]; only meaningful for neighbours
+    const FaceTable* table; // only ever with at most FaceTable::maxnodes nodes
+
+    explicit Shape(const CoxeterGraph& cg, const FaceTable* table = nullptr)
+      : bd{cg}, orders(num_vertices(cg)*num_vertices(cg)), table{table} {
+        const vsize_t n = num_vertices(cg);
+        auto edgits = boost::edges(cg);
+        for (auto eit = edgits.first; eit != edgits.second; ++eit) {
+            const vsize_t s = boost::source(*eit, cg), t = boost::target(*eit, cg);
+            orders[s*n + t] = orders[t*n + s] = cg[*eit].order;
+        }
+    }
+
+    unsigned order(vsize_t u, vsize_t v) const { return orders[u*bd.size() + v]; }
+
+    bool isface(Mask s) const {
+        return table ? table->isface(s, bd.ringed()) : bd.allringed(s);
+    }
+};
+
+namespace { // this-file-only (internal linkage)
+    /* (n choose k), for n up to IntervalCache::maxnodes: all of these fit in
+     * a Count128, as (128 choose 64) < 2^125 */
+    Count128 choose(vsize_t n, vsize_t k) {
+        static const vector<vector<Count128>> pascal = [] {
+            vector<vector<Count128>> rows{{1}};
+            for (vsize_t m = 1; m <= IntervalCache::maxnodes; ++m) {
+                vector<Count128> row(m + 1, 1);
+                for (vsize_t i = 1; i < m; ++i)
+                    row[i] = rows[m - 1][i - 1] + rows[m - 1][i];
+                rows.push_back(std::move(row));
+            }
+            return rows;
+        }();
+        return pascal[n][k];
+    }
+
+    /* Canonical code of the subtree of c hanging from v, away from parent:
+     * "(", a "*" if v is ringed, then each child's edge order and code,
+     * sorted, then ")". */
+    template <typename Mask>
+    string rooted(const IntervalCache::Shape<Mask>& sh, Mask c, vsize_t v, Mask parent) {
+        typedef MaskBits<Mask> B;
+        vector<string> kids;
+        for (Mask rest = sh.bd.neighbours(v) & c & ~parent; rest; rest &= rest - 1) {
+            const vsize_t u = B::low(rest);
+            kids.push_back(to_string(sh.order(v, u)) + rooted(sh, c, u, B::bit(v)));
+        }
+        std::sort(kids.begin(), kids.end());
+        string code = sh.bd.ringed() & B::bit(v) ? "(*" : "(";
+        for (const auto& k : kids)
+            code += k;
+        code += ')';
+        return code;
+    }
+
+    /* Key for the connected subdiagram on c. For a tree, root it at its
+     * center (or central edge) and take the canonical code, so isomorphic
+     * trees get the same key. Otherwise, just list the ringed nodes and
+     * edges, numbering the nodes of c in order. */
+    template <typename Mask>
+    string canonical(const IntervalCache::Shape<Mask>& sh, Mask c) {
+        typedef MaskBits<Mask> B;
+        vsize_t edges = 0;
+        for (Mask rest = c; rest; rest &= rest - 1)
+            edges += B::count(sh.bd.neighbours(B::low(rest)) & c);
+        if (edges/2 + 1 == B::count(c)) {
+            // strip leaves until one or two nodes remain
+            Mask core = c;
+            while (B::count(core) > 2) {
+                Mask leaves = 0;
+                for (Mask rest = core; rest; rest &= rest - 1) {
+                    const vsize_t v = B::low(rest);
+                    if (B::count(sh.bd.neighbours(v) & core) <= 1)
+                        leaves |= B::bit(v);
+                }
+                core &= ~leaves;
+            }
+            const vsize_t a = B::low(core);
+            if (B::count(core) == 1)
+                return 'V' + rooted(sh, c, a, Mask{0});
+            const vsize_t b = B::low(core & (core - 1));
+            string ha = rooted(sh, c, a, B::bit(b)), hb = rooted(sh, c, b, B::bit(a));
+            if (hb < ha)
+                ha.swap(hb);
+            return 'E' + to_string(sh.order(a, b)) + ha + hb;
+        }
+        string code = "G";
+        vsize_t i = 0;
+        for (Mask rest = c; rest; rest &= rest - 1, ++i) {
+            const vsize_t v = B::low(rest);
+            code += sh.bd.ringed() & B::bit(v) ? '*' : '.';
+            // neighbours of v later in c, by their index in c
+            for (Mask nb = sh.bd.neighbours(v) & c & ~(B::bit(v) - 1); nb; nb &= nb - 1) {
+                const vsize_t u = B::low(nb);
+                code += to_string(B::count(c & (B::bit(u) - 1))) + ':'
+                      + to_string(sh.order(v, u)) + ';';
+            }
+        }
+        return code;
+    }
+}
+
+/* Chains below the face s, as a product over its components */
+template <typename Mask>
+Count128 IntervalCache::interval(const Shape<Mask>& sh, Mask s) {
+    typedef MaskBits<Mask> B;
+    Count128 total = 1;
+    vsize_t size = 0;
+    auto factor = [&](Mask c) {
+        size += B::count(c);
+        total *= choose(size, B::count(c));
+        total *= connected(sh, c);
+    };
+    if (sh.table) {
+        for (auto c : sh.table->components(s))
+            factor(c);
+    } else {
+        for (Mask rest = s; rest; ) {
+            const Mask c = sh.bd.component(rest, B::low(rest));
+            rest &= ~c;
+            factor(c);
+        }
+    }
+    return total;
+}
+
+/* Chains below the connected face c: the sum over its faces one rank down */
+template <typename Mask>
+Count128 IntervalCache::connected(const Shape<Mask>& sh, Mask c) {
+    typedef MaskBits<Mask> B;
+    string key = canonical(sh, c);
+    auto it = memo.find(key);
+    if (it != memo.end()) {
+        ++nhits;
+        return it->second;
+    }
+    Count128 total = 0;
+    for (Mask rest = c; rest; rest &= rest - 1) {
+        const Mask below = c & ~B::bit(B::low(rest));
+        if (sh.isface(below))
+            total += interval(sh, below);
+    }
+    memo.emplace(std::move(key), total);
+    return total;
+}
+
+template <typename Mask>
+Count128 IntervalCache::flagorbits(const Shape<Mask>& sh) {
+    typedef MaskBits<Mask> B;
+    const Mask all = sh.bd.all();
+    if (sh.isface(all))
+        return interval(sh, all);
+    // The whole diagram isn't a face, but it's still the head of the poset,
+    // above every face of rank n - 1; if there are none, it has no children.
+    Count128 total = 0;
+    bool any = false;
+    for (Mask rest = all; rest; rest &= rest - 1) {
+        const Mask below = all & ~B::bit(B::low(rest));
+        if (sh.isface(below)) {
+            total += interval(sh, below);
+            any = true;
+        }
+    }
+    return any ? total : Count128{1};
+}
+
+constexpr vsize_t IntervalCache::maxnodes;
+
+Count128 IntervalCache::chains(const CoxeterGraph& cg, nodemask s) {
+    if (num_vertices(cg) <= MaskBits<std::uint32_t>::bits)
+        return interval(Shape<std::uint32_t>{cg}, static_cast<std::uint32_t>(s));
+    return interval(Shape<nodemask>{cg}, s);
+}
+
+Count128 IntervalCache::flagorbits(const CoxeterGraph& cg) {
+    if (num_vertices(cg) <= MaskBits<std::uint32_t>::bits)
+        return flagorbits(Shape<std::uint32_t>{cg});
+    if (num_vertices(cg) <= MaskBits<nodemask>::bits)
+        return flagorbits(Shape<nodemask>{cg});
+    return flagorbits(Shape<widemask>{cg});
+}
+
+Count128 IntervalCache::flagorbits(const CoxeterGraph& cg, const FaceTable& table) {
+    // the table has at most FaceTable::maxnodes nodes, so 32 bits hold them
+    return flagorbits(Shape<std::uint32_t>{cg, &table});
+}
@@ -0,0 +1,79 @@
+#ifndef NAM_INTERVALCACHE_H
+#define NAM_INTERVALCACHE_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include "coxeter.h"
+#include "bitdiagram.h"
+#include "facetable.h"
+#include "count128.h"
+
+/*****************
+ * IntervalCache *
+ *****************/
+
+/* Chain counts for the lower intervals of faces, memoized by isomorphism
+ * class, so that the work is shared between faces of one diagram and
+ * between different diagrams and ringings.
+ *
+ * The faces below a face S depend only on the subdiagram on S and its
+ * ringing, so the count is cached under a canonical form of that ringed,
+ * edge-labeled subdiagram. (Edge orders don't change the count, but they
+ * are part of the key, so that statistics which do depend on them can
+ * share it.) Trees, which include all the finite diagrams, get a true
+ * canonical form; other subdiagrams are keyed by their nodes in order,
+ * which is exact but only matches copies laid out the same way.
+ *
+ * If S has several components, its interval is the product of theirs.
+ * A chain in the product interleaves one chain from each, so its count is
+ * the multinomial (|S| choose |S_1|, |S_2|, ...) times theirs; only
+ * connected subdiagrams are ever stored.
+ *
+ * The work is done with the narrowest mask word that holds the diagram
+ * (see BasicBitDiagram), up to 128 nodes. The keys don't depend on the
+ * word, so diagrams of every size share the one memo. */
+class IntervalCache {
+    public:
+    template <typename Mask>
+    struct Shape; // a diagram as the cache sees it; see intervalcache.cc
+
+    static constexpr vsize_t maxnodes = MaskBits<widemask>::bits;
+
+    private:
+    std::unordered_map<std::string, Count128> memo;
+    std::size_t nhits;
+
+    template <typename Mask>
+    Count128 interval(const Shape<Mask>& sh, Mask s);
+    template <typename Mask>
+    Count128 connected(const Shape<Mask>& sh, Mask c);
+    template <typename Mask>
+    Count128 flagorbits(const Shape<Mask>& sh);
+
+    public:
+    IntervalCache() : nhits{0} {}
+
+    /* The number of maximal chains below the face s of cg:
+     * the same as numpaths() of its PosetNode in FaceOrbitPoset{cg}.
+     * s must be a face (have a ringed node in every component.)
+     * Throws std::length_error if cg has more than BitDiagram::maxnodes nodes */
+    Count128 chains(const CoxeterGraph& cg, nodemask s);
+
+    /* The number of flag orbits of cg: FaceOrbitPoset{cg}.head->numpaths().
+     * Throws std::length_error if cg has more than maxnodes nodes */
+    Count128 flagorbits(const CoxeterGraph& cg);
+
+    /* The same, taking components and face checks from table,
+     * which must have been made from a diagram of the same shape as cg
+     * (the ringing can differ.) */
+    Count128 flagorbits(const CoxeterGraph& cg, const FaceTable& table);
+
+    /* Number of isomorphism classes stored */
+    std::size_t size() const { return memo.size(); }
+
+    /* Number of lookups answered from the cache */
+    std::size_t hits() const { return nhits; }
+};
+
+#endif // NAM_INTERVALCACHE_H
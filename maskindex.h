@@ -0,0 +1,85 @@
+#ifndef NAM_MASKINDEX_H
+#define NAM_MASKINDEX_H
+
+#include <cstdint>
+#include <utility> // pair
+#include <vector>
+#include "bitdiagram.h" // nodemask
+
+/*************
+ * MaskIndex *
+ *************/
+
+/* An open-addressing hash index from node masks to dense ids 0, 1, 2, ...
+ * handed out in order of insertion. The caller keeps whatever goes with
+ * each id in its own arrays, so those stay contiguous.
+ * Slots hold the mask next to its id, and probing is linear, so a lookup
+ * usually touches a single cache line. The table is at most half full. */
+class MaskIndex {
+    struct Slot {
+        nodemask key;
+        std::uint32_t id; // npos if the slot is unused
+    };
+    std::vector<Slot> slots; // size is a power of two
+    std::uint32_t count;
+    unsigned shift; // 64 - log2(slots.size())
+
+    /* Fibonacci hashing: the top bits of m times 2^64/phi */
+    std::size_t home(nodemask m) const {
+        return (m * UINT64_C(0x9e3779b97f4a7c15)) >> shift;
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<Slot> old(capacity, Slot{0, npos});
+        old.swap(slots); // slots is now the new, empty table
+        shift = 64;
+        for (std::size_t c = capacity; c > 1; c >>= 1)
+            --shift;
+        for (const auto& s : old) {
+            if (s.id != npos)
+                slots[probe(s.key)] = s;
+        }
+    }
+
+    /* The slot holding m, or the empty slot where it belongs */
+    std::size_t probe(nodemask m) const {
+        const std::size_t wrap = slots.size() - 1;
+        std::size_t i = home(m);
+        while (slots[i].id != npos && slots[i].key != m)
+            i = (i + 1) & wrap;
+        return i;
+    }
+
+    public:
+    static constexpr std::uint32_t npos = ~std::uint32_t{0};
+
+    MaskIndex() : count{0} { rehash(16); }
+
+    std::uint32_t size() const { return count; }
+
+    /* Forget all the masks, but keep the storage */
+    void clear() {
+        for (auto& s : slots)
+            s.id = npos;
+        count = 0;
+    }
+
+    /* Find m, giving it the next id if it is not present.
+     * Returns its id, and whether it was newly inserted. */
+    std::pair<std::uint32_t, bool> insert(nodemask m) {
+        if (2*(count + 1) > slots.size())
+            rehash(2*slots.size());
+        Slot& s = slots[probe(m)];
+        if (s.id != npos)
+            return {s.id, false};
+        s = {m, count};
+        return {count++, true};
+    }
+
+    /* The id of m, or npos if it is not present */
+    std::uint32_t find(nodemask m) const {
+        return slots[probe(m)].id;
+    }
+};
+
+#endif // NAM_MASKINDEX_H
@@ -0,0 +1,212 @@
+#include "orbitcache.h"
+#include <cstdio> // rename, remove
+#include <cstring> // memcmp, memcpy
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h> // open
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <unistd.h> // close, getpid
+
+using std::vector;
+using std::string;
+using boost::num_vertices;
+typedef HasseDiagram::nodeid nodeid;
+
+namespace { // this-file-only (internal linkage)
+    const char magic[8] = {'C', 'X', 'O', 'R', 'B', 'I', 'T', 'S'};
+    const std::uint32_t version = 1;
+    const std::uint32_t byteorder = 0x01020304;
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version, byteorder;
+        std::uint64_t diagrambytes, numnodes, numranks, numlinks, numflags, numentries;
+    };
+    static_assert(sizeof(Header) == 64, "the header is eight words");
+
+    std::size_t padded(std::size_t n) {
+        return (n + 7) & ~std::size_t{7};
+    }
+
+    /* Append n objects from p (or zeros, if p is null) to buf, then zeros
+     * up to a multiple of 8 bytes */
+    template <typename T>
+    void put(string& buf, const T* p, std::size_t n) {
+        if (p)
+            buf.append(reinterpret_cast<const char*>(p), n*sizeof(T));
+        else
+            buf.append(n*sizeof(T), '\0');
+        buf.append(padded(buf.size()) - buf.size(), '\0');
+    }
+
+    /* The diagram, as it is saved: the numbers of nodes and edges,
+     * (ringed, x, y) for each node, and (source, target, order) for each edge */
+    vector<std::uint32_t> diagramwords(const CoxeterGraph& cg) {
+        vector<std::uint32_t> words{static_cast<std::uint32_t>(num_vertices(cg)),
+                                    static_cast<std::uint32_t>(num_edges(cg))};
+        for (auto v : boost::make_iterator_range(vertices(cg))) {
+            words.push_back(cg[v].ringed);
+            words.push_back(static_cast<std::uint32_t>(cg[v].x_coord));
+            words.push_back(static_cast<std::uint32_t>(cg[v].y_coord));
+        }
+        for (auto e : boost::make_iterator_range(edges(cg))) {
+            words.push_back(source(e, cg));
+            words.push_back(target(e, cg));
+            words.push_back(cg[e].order);
+        }
+        return words;
+    }
+
+    /* The diagram back from its words, which there are n of */
+    CoxeterGraph fromwords(const std::uint32_t* words, std::size_t n) {
+        if (n < 2 || n != 2 + 3*std::size_t{words[0]} + 3*std::size_t{words[1]})
+            throw std::runtime_error("Orbit file: bad diagram");
+        CoxeterGraph cg{words[0]};
+        const std::uint32_t* w = words + 2;
+        for (std::uint32_t v = 0; v < words[0]; ++v, w += 3)
+            cg[v] = {w[0] != 0, static_cast<int>(w[1]), static_cast<int>(w[2])};
+        for (std::uint32_t e = 0; e < words[1]; ++e, w += 3) {
+            if (w[0] >= words[0] || w[1] >= words[0])
+                throw std::runtime_error("Orbit file: bad diagram");
+            boost::add_edge(w[0], w[1], {w[2]}, cg);
+        }
+        return cg;
+    }
+
+    /* The whole file at path, mapped read-only into memory; it's unmapped
+     * when the last copy of the pointer goes */
+    std::shared_ptr<const void> mapfile(const string& path, std::size_t& length) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Can't open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+            close(fd);
+            throw std::runtime_error(path + " is not an orbit file");
+        }
+        length = st.st_size;
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping stays
+        if (p == MAP_FAILED)
+            throw std::runtime_error("Can't map " + path);
+        return {p, [length](const void* q) { munmap(const_cast<void*>(q), length); }};
+    }
+}
+
+void saveorbits(const string& path, const HasseDiagram& hasse, const CompactOrbitGraph& orbit) {
+    const auto words = diagramwords(hasse.diagram());
+    const auto& h = hasse.layout();
+    const auto& o = orbit.layout();
+    Header head;
+    std::memcpy(head.magic, magic, sizeof magic);
+    head.version = version;
+    head.byteorder = byteorder;
+    head.diagrambytes = 4*words.size();
+    head.numnodes = h.size;
+    head.numranks = h.numranks;
+    head.numlinks = h.numedges;
+    head.numflags = o.numvertices;
+    head.numentries = o.start[o.numvertices];
+
+    string buf;
+    put(buf, &head, 1);
+    put(buf, words.data(), words.size());
+    put(buf, h.masks, h.size);
+    put(buf, h.rankstart, h.numranks + 1);
+    put(buf, h.downstart, h.size + 1);
+    put(buf, h.downs, h.numedges);
+    put(buf, h.upstart, h.size + 1);
+    put(buf, h.ups, h.numedges);
+    put(buf, o.start, o.numvertices + 1);
+    put(buf, o.adj, head.numentries);
+
+    const string tmp = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(tmp, std::ios::binary);
+        file.write(buf.data(), buf.size());
+        if (!file) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("Can't write " + tmp);
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("Can't rename " + tmp + " to " + path);
+    }
+}
+
+OrbitFile loadorbits(const string& path) {
+    std::size_t length;
+    auto store = mapfile(path, length);
+    const char* base = static_cast<const char*>(store.get());
+    Header head;
+    std::memcpy(&head, base, sizeof head);
+    if (std::memcmp(head.magic, magic, sizeof magic) != 0 || head.version != version
+            || head.byteorder != byteorder)
+        throw std::runtime_error(path + " is not an orbit file of version 1 in this byte order");
+    // Every count is at most the length, so none of this overflows
+    if (head.diagrambytes > length || head.numnodes > length || head.numranks > length
+            || head.numlinks > length || head.numflags > length || head.numentries > length)
+        throw std::runtime_error(path + " is truncated or corrupt");
+    std::size_t at = sizeof head;
+    const std::size_t diagram = at;
+    at += padded(head.diagrambytes);
+    const std::size_t masks = at;
+    at += padded(8*head.numnodes);
+    const std::size_t rankstart = at;
+    at += padded(4*(head.numranks + 1));
+    const std::size_t downstart = at;
+    at += padded(4*(head.numnodes + 1));
+    const std::size_t downs = at;
+    at += padded(4*head.numlinks);
+    const std::size_t upstart = at;
+    at += padded(4*(head.numnodes + 1));
+    const std::size_t ups = at;
+    at += padded(4*head.numlinks);
+    const std::size_t start = at;
+    at += padded(8*(head.numflags + 1));
+    const std::size_t adj = at;
+    at += padded(8*head.numentries);
+    if (at != length || head.diagrambytes % 4 != 0)
+        throw std::runtime_error(path + " is truncated or corrupt");
+
+    const HasseDiagram::Layout h{head.numnodes, head.numranks, head.numlinks,
+        reinterpret_cast<const nodemask*>(base + masks),
+        reinterpret_cast<const nodeid*>(base + rankstart),
+        reinterpret_cast<const std::uint32_t*>(base + downstart),
+        reinterpret_cast<const std::uint32_t*>(base + upstart),
+        reinterpret_cast<const nodeid*>(base + downs),
+        reinterpret_cast<const nodeid*>(base + ups)};
+    const CompactOrbitGraph::Layout o{head.numflags,
+        reinterpret_cast<const std::uint64_t*>(base + start),
+        reinterpret_cast<const std::uint64_t*>(base + adj)};
+    if (h.downstart[h.size] != h.numedges || h.upstart[h.size] != h.numedges
+            || o.start[o.numvertices] != head.numentries)
+        throw std::runtime_error(path + " is truncated or corrupt");
+    CoxeterGraph cg = fromwords(reinterpret_cast<const std::uint32_t*>(base + diagram),
+                                head.diagrambytes/4);
+    return {HasseDiagram{std::move(cg), h, store}, CompactOrbitGraph{o, store}};
+}
+
+OrbitFile loadorbits(const string& path, const CoxeterGraph& cg) {
+    OrbitFile file = loadorbits(path);
+    if (diagramwords(file.hasse.diagram()) != diagramwords(cg))
+        throw std::runtime_error(path + " is for a different diagram");
+    return file;
+}
+
+string orbitfilename(const CoxeterGraph& cg) {
+    // 64-bit FNV-1a of the saved diagram
+    const auto words = diagramwords(cg);
+    std::uint64_t h = UINT64_C(0xcbf29ce484222325);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(words.data());
+    for (std::size_t i = 0; i < 4*words.size(); ++i)
+        h = (h ^ p[i]) * UINT64_C(0x100000001b3);
+    static const char hex[] = "0123456789abcdef";
+    string name(16, '0');
+    for (int d = 15; d >= 0; --d, h >>= 4)
+        name[d] = hex[h & 15u];
+    return name + ".orb";
+}
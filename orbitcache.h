@@ -0,0 +1,59 @@
+#ifndef NAM_ORBITCACHE_H
+#define NAM_ORBITCACHE_H
+
+#include <string>
+#include "coxeter.h"
+#include "hassediagram.h"
+#include "orbitgraph.h"
+
+/***************
+ * Orbit files *
+ ***************/
+
+/* A poset of face orbits and its orbit graph, saved in a file so they need
+ * not be worked out again. The file is the arrays of the HasseDiagram and
+ * the CompactOrbitGraph as they are in memory, so loading it maps it into
+ * memory and points at them: nothing is read or copied until it's used,
+ * except the Coxeter diagram, which is rebuilt (it has only a few nodes).
+ *
+ * The format (version 1) is a header of 8-byte words:
+ *   "CXORBITS", version and byte order (two 32-bit words, 1 and 0x01020304),
+ *   then the counts: diagram bytes, nodes, ranks, links, flags, and
+ *   adjacency entries;
+ * then these sections, each padded with zeros to a multiple of 8 bytes:
+ *   the diagram: nodes and edges (32-bit), then (ringed, x, y) for each node
+ *     and (source, target, order) for each edge (32-bit each), in order;
+ *   the masks (64-bit), rankstart, downstart, downs, upstart, ups (32-bit),
+ *     as in HasseDiagram::Layout;
+ *   start and adj (64-bit), as in CompactOrbitGraph::Layout.
+ * Everything is in the byte order of the machine that wrote it; a file
+ * from the other order is refused. The same poset always gives the same
+ * bytes, so files can be compared or deduplicated by checksum. */
+
+struct OrbitFile {
+    HasseDiagram hasse;
+    CompactOrbitGraph orbit;
+};
+
+/* Write hasse and its orbit graph to path. They are written to a temporary
+ * file first and renamed into place, so other processes reading the same
+ * path see the whole file or none of it.
+ * Throws std::runtime_error if the file can't be written. */
+void saveorbits(const std::string& path, const HasseDiagram& hasse,
+                const CompactOrbitGraph& orbit);
+
+/* Map the file at path into memory.
+ * Throws std::runtime_error if it can't be opened, or is not a whole
+ * orbit file of this version and byte order. Only the header and the sizes
+ * are checked, not every link, so that loading takes no time at all. */
+OrbitFile loadorbits(const std::string& path);
+
+/* The same, but also throws std::runtime_error unless the file is for
+ * the Coxeter diagram cg, ringed the same way */
+OrbitFile loadorbits(const std::string& path, const CoxeterGraph& cg);
+
+/* A file name for the poset of cg and its ringing, from a hash of its
+ * saved form: 16 hex digits and ".orb" */
+std::string orbitfilename(const CoxeterGraph& cg);
+
+#endif // NAM_ORBITCACHE_H
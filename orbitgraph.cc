@@ -0,0 +1,201 @@
+#include "orbitgraph.h"
+#include <algorithm>
+#include <stdexcept>
+#include "TeXout.h"
+#include "parallel.h"
+
+using std::vector;
+
+namespace {
+    /* The packages and settings the orbit graphs need, once per document */
+    void orbitpreamble(TeXout& tex) {
+        static bool inited {false};
+
+        if (!inited) {
+            tex.usepackage("tikz");
+            tex.usetikzlibrary("graphs");
+            tex.usetikzlibrary("graphdrawing");
+            tex.usetikzlibrary("quotes");
+            tex.addtopreamble("\\usegdlibrary{force}\n");
+            tex.addtopreamble("\\tikzset{\n"
+                "  graphs/edges={inner sep=1pt},\n"
+                "  graphs/nodes={fill,circle,inner sep=1.6pt}\n"
+                "}\n");
+            inited = true;
+        }
+    }
+
+    /* The TikZ graph, for any BGL graph with edges labeled by EdgeRank */
+    template <typename Graph>
+    TeXout& orbittikz(TeXout& tex, const Graph& og) {
+        using boost::edges;
+        using boost::source;
+        using boost::target;
+
+        orbitpreamble(tex);
+        auto edgits = edges(og);
+        if (edgits.first == edgits.second)
+            return tex;
+        tex << "\\graph[spring electrical layout,horizontal= 0 to 1] {\n";
+        for (auto eit = edgits.first; eit != edgits.second; ++eit) {
+            tex << source(*eit, og) << "/ --[\"" << og[*eit].rank
+                << "\"] " << target(*eit, og) << "/;\n";
+        }
+        return tex << "};\n";
+    }
+}
+
+vector<OrbitEdge> orbitedges(const HasseDiagram& hasse, unsigned nthreads) {
+    typedef HasseDiagram::nodeid nodeid;
+    const nodeid none = ~nodeid{0}; // below the bottom of a chain
+    if (hasse.size() == 0)
+        return {};
+
+    // A flag's number is the sum, over its links, of the chains through
+    // the parent's earlier children (see ChainRanking). Every maximal chain
+    // is the same length, so each node is at a fixed place (height) in all
+    // the chains through it.
+    const auto numpaths = hasse.numpaths();
+    if (!(numpaths[hasse.head()] < Count128{std::uint64_t{1} << 32}))
+        throw std::overflow_error("orbitedges: too many flags to number in 32 bits");
+    vector<std::uint64_t> paths(hasse.size());
+    vector<unsigned> height(hasse.size());
+    vector<std::uint32_t> downstart(1, 0);
+    vector<std::uint64_t> label;
+    for (nodeid i = 0; i < hasse.size(); ++i) {
+        paths[i] = numpaths[i].as<std::uint64_t>();
+        std::uint64_t before = 0;
+        for (auto kid : hasse.children(i)) {
+            label.push_back(before);
+            before += paths[kid];
+        }
+        downstart.push_back(label.size());
+        height[i] = hasse.children(i).empty() ? 0 : height[hasse.children(i).front()] + 1;
+    }
+    const std::size_t L = height[hasse.head()] + 1;
+
+    // Flags that differ only in the entry below b are the same chain down
+    // through b and up from a, the entry below that (or none), going
+    // through two different middles m. Those at one of b's diamonds,
+    // numbered from the top of b, are lo + D and hi + D, for each numbering
+    // D of the chains below a; with more than two middles, every pair.
+    struct Diamond {
+        nodeid a;
+        std::uint64_t lo, hi;
+    };
+    vector<std::uint32_t> diamondstart(1, 0);
+    vector<Diamond> diamonds;
+    vector<std::pair<nodeid, std::uint64_t>> below; // (a, offset through m)
+    for (nodeid b = 0; b < hasse.size(); ++b) {
+        below.clear();
+        const auto ms = hasse.children(b);
+        for (std::size_t c = 0; c < ms.size(); ++c) {
+            const auto as = hasse.children(ms[c]);
+            const std::uint64_t down = label[downstart[b] + c];
+            if (as.empty())
+                below.push_back({none, down});
+            for (std::size_t k = 0; k < as.size(); ++k)
+                below.push_back({as[k], down + label[downstart[ms[c]] + k]});
+        }
+        std::sort(below.begin(), below.end());
+        for (std::size_t x = 0; x < below.size(); ++x) {
+            for (std::size_t y = x + 1; y < below.size() && below[y].first == below[x].first; ++y)
+                diamonds.push_back({below[x].first, below[x].second, below[y].second});
+        }
+        diamondstart.push_back(diamonds.size());
+    }
+
+    // For each place d, go down every path from the head to each b at
+    // height d + 1, adding up the labels on the way, and join the flags
+    // at each of b's diamonds. A block of places is one walk, which goes
+    // no lower than the lowest b it wants; it holds only the path.
+    vector<vector<OrbitEdge>> found(L);
+    parallel_for(nthreads, L, [&](std::size_t first, std::size_t last, unsigned) {
+        struct Step {
+            nodeid node;
+            std::uint32_t pick; // the next child to go down to
+            std::uint64_t top;  // the number of the first flag through node
+        };
+        vector<Step> path{{hasse.head(), 0, 0}};
+        while (!path.empty()) {
+            Step& at = path.back();
+            if (at.pick == 0 && height[at.node] > first && height[at.node] <= last) {
+                const std::size_t d = height[at.node] - 1;
+                for (std::uint32_t x = diamondstart[at.node]; x < diamondstart[at.node + 1]; ++x) {
+                    const Diamond& dia = diamonds[x];
+                    const std::uint64_t n = dia.a == none ? 1 : paths[dia.a];
+                    for (std::uint64_t D = 0; D < n; ++D)
+                        found[d].push_back({static_cast<std::uint32_t>(at.top + dia.lo + D),
+                                            static_cast<std::uint32_t>(at.top + dia.hi + D),
+                                            static_cast<int>(d)});
+                }
+            }
+            const auto kids = hasse.children(at.node);
+            if (at.pick < kids.size() && height[at.node] > first + 1) {
+                const Step next{kids[at.pick], 0, at.top + label[downstart[at.node] + at.pick]};
+                ++at.pick;
+                path.push_back(next);
+            } else {
+                path.pop_back();
+            }
+        }
+    });
+
+    // In order of their ends, as comparing each pair of flags in turn would
+    vector<OrbitEdge> edges;
+    for (const auto& rank : found)
+        edges.insert(edges.end(), rank.begin(), rank.end());
+    std::sort(edges.begin(), edges.end(), [](const OrbitEdge& a, const OrbitEdge& b) {
+        return a.i < b.i || (a.i == b.i && a.j < b.j);
+    });
+    return edges;
+}
+
+OrbitGraph makeOrbit(const HasseDiagram& hasse, unsigned nthreads) {
+    OrbitGraph og {ChainEnumerator{hasse}.size().as<std::size_t>()};
+    for (const auto& ed : orbitedges(hasse, nthreads))
+        boost::add_edge(ed.i, ed.j, {ed.rank}, og);
+    return og;
+}
+
+/*********************
+ * CompactOrbitGraph *
+ *********************/
+
+const std::uint64_t CompactOrbitGraph::nostart = 0;
+
+CompactOrbitGraph::CompactOrbitGraph(std::size_t numvertices, const vector<OrbitEdge>& edges) {
+    // Count the degrees, then fill each vertex's run in one pass. Every
+    // neighbour below a vertex comes before it as i, and every one above
+    // comes after, in increasing order, so each run comes out increasing.
+    auto arr = std::make_shared<std::pair<vector<std::uint64_t>, vector<std::uint64_t>>>();
+    vector<std::uint64_t>& start = arr->first;
+    vector<std::uint64_t>& adj = arr->second;
+    start.assign(numvertices + 1, 0);
+    adj.resize(2*edges.size());
+    for (const auto& ed : edges) {
+        ++start[ed.i + 1];
+        ++start[ed.j + 1];
+    }
+    for (std::size_t v = 0; v < numvertices; ++v)
+        start[v + 1] += start[v];
+    vector<std::uint64_t> fill(start.begin(), start.end() - 1);
+    for (const auto& ed : edges) {
+        adj[fill[ed.i]++] = std::uint64_t{ed.j} << 8 | ed.rank;
+        adj[fill[ed.j]++] = std::uint64_t{ed.i} << 8 | ed.rank;
+    }
+    at = {numvertices, start.data(), adj.data()};
+    store = std::move(arr);
+}
+
+CompactOrbitGraph makeCompactOrbit(const HasseDiagram& hasse, unsigned nthreads) {
+    return {ChainEnumerator{hasse}.size().as<std::size_t>(), orbitedges(hasse, nthreads)};
+}
+
+TeXout& operator<<(TeXout& tex, const OrbitGraph& og) {
+    return orbittikz(tex, og);
+}
+
+TeXout& operator<<(TeXout& tex, const CompactOrbitGraph& og) {
+    return orbittikz(tex, og);
+}
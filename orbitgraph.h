@@ -0,0 +1,217 @@
+#ifndef NAM_ORBITGRAPH_H
+#define NAM_ORBITGRAPH_H
+
+#include <cstdint>
+#include <memory> // shared_ptr
+#include <vector>
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include "hassediagram.h"
+
+class TeXout; //forward declaration; see TeXout.h
+
+/****************
+ * Orbit Graphs *
+ ****************/
+
+/* The graph of flag orbits (the symmetry type graph), numbered as
+ * ChainEnumerator gives them, with an edge labeled i between two flags
+ * which differ only at rank i. */
+
+struct EdgeRank {
+    int rank;
+};
+
+typedef boost::adjacency_list<boost::vecS, //container for edges at each vertex (vector)
+                              boost::vecS, //container for the vertices (vector)
+                              boost::undirectedS,
+                              boost::no_property, //no vertex properties
+                              EdgeRank> // edges have rank
+                              OrbitGraph;
+
+/* An edge between flags i < j, which differ at rank */
+struct OrbitEdge {
+    std::uint32_t i, j;
+    int rank;
+};
+
+/* All the edges of the orbit graph of hasse, in increasing order of (i, j).
+ * These come straight from the diamonds of the Hasse diagram, numbering
+ * the flags through each one as ChainRanking does, without listing any
+ * flags: the working memory beyond the edges is a path from the head.
+ * With nthreads > 1, the ranks are shared out among that many threads;
+ * the result is the same either way.
+ * Throws std::overflow_error if there are 2^32 flags or more, as the ends
+ * of an edge are numbered in 32 bits. */
+std::vector<OrbitEdge> orbitedges(const HasseDiagram& hasse, unsigned nthreads = 1);
+
+/*********************
+ * CompactOrbitGraph *
+ *********************/
+
+/* An orbit graph in compressed sparse rows, built all at once and never
+ * changed. Each vertex's edges are one run of 64-bit words, each holding
+ * the neighbour above the rank (neighbour << 8 | rank), in increasing order
+ * of neighbour; so an edge costs 16 bytes (it's listed at both ends), and
+ * a vertex 8. It is a BGL graph (see the graph_traits below), for reading:
+ * vertices, edges, out_edges, source, target, and g[e].rank. */
+class CompactOrbitGraph {
+    public:
+    typedef std::size_t vertex;
+
+    /* Where the arrays are: the edges of v are adj[start[v]] ...
+     * before adj[start[v+1]], for v < numvertices */
+    struct Layout {
+        std::size_t numvertices;
+        const std::uint64_t* start;
+        const std::uint64_t* adj;
+    };
+
+    private:
+    Layout at;
+    std::shared_ptr<const void> store; // holds the arrays: vectors, or a mapped file
+    static const std::uint64_t nostart; // 0, for the graph with no vertices
+
+    public:
+
+    /* An edge, as seen from one of its ends */
+    struct edge {
+        vertex from;
+        std::uint64_t entry;
+    };
+
+    static vertex neighbour(std::uint64_t entry) { return entry >> 8; }
+    static int rank(std::uint64_t entry) { return entry & 0xff; }
+
+    CompactOrbitGraph() : at{0, &nostart, nullptr} {}
+
+    /* From the edges, in increasing order of (i, j), as orbitedges gives them */
+    CompactOrbitGraph(std::size_t numvertices, const std::vector<OrbitEdge>& edges);
+
+    /* Over arrays kept elsewhere (such as a file in memory, see orbitcache.h),
+     * which store keeps alive; nothing is copied */
+    CompactOrbitGraph(const Layout& layout, std::shared_ptr<const void> store)
+      : at(layout), store(std::move(store)) {}
+
+    const Layout& layout() const { return at; }
+    std::size_t numvertices() const { return at.numvertices; }
+    std::size_t numedges() const { return at.start[at.numvertices]/2; }
+    const std::uint64_t* adjbegin(vertex v) const { return at.adj + at.start[v]; }
+    const std::uint64_t* adjend(vertex v) const { return at.adj + at.start[v + 1]; }
+
+    EdgeRank operator[](const edge& e) const { return {rank(e.entry)}; }
+
+    /* Iterates over the edges at one vertex */
+    class out_edge_iterator : public boost::iterator_facade<out_edge_iterator, edge,
+                                  boost::random_access_traversal_tag, edge> {
+        friend class boost::iterator_core_access;
+        vertex v;
+        const std::uint64_t* p;
+
+        edge dereference() const { return {v, *p}; }
+        bool equal(const out_edge_iterator& o) const { return p == o.p; }
+        void increment() { ++p; }
+        void decrement() { --p; }
+        void advance(std::ptrdiff_t n) { p += n; }
+        std::ptrdiff_t distance_to(const out_edge_iterator& o) const { return o.p - p; }
+
+        public:
+        out_edge_iterator() : v{0}, p{nullptr} {}
+        out_edge_iterator(vertex v, const std::uint64_t* p) : v{v}, p{p} {}
+    };
+
+    /* Iterates over all the edges, each once, from its lower end,
+     * in increasing order of (source, target) */
+    class edge_iterator : public boost::iterator_facade<edge_iterator, edge,
+                              boost::forward_traversal_tag, edge> {
+        friend class boost::iterator_core_access;
+        const CompactOrbitGraph* g;
+        vertex v;
+        std::size_t pos; // index into the adjacency entries
+
+        /* Move on to the first edge from here up to a higher neighbour */
+        void settle() {
+            while (v < g->numvertices() && (pos == g->at.start[v + 1]
+                                            || neighbour(g->at.adj[pos]) < v)) {
+                if (pos == g->at.start[v + 1])
+                    ++v;
+                else
+                    ++pos;
+            }
+        }
+        edge dereference() const { return {v, g->at.adj[pos]}; }
+        bool equal(const edge_iterator& o) const { return pos == o.pos && v == o.v; }
+        void increment() { ++pos; settle(); }
+
+        public:
+        edge_iterator() : g{nullptr}, v{0}, pos{0} {}
+        edge_iterator(const CompactOrbitGraph* g, vertex v, std::size_t pos)
+          : g{g}, v{v}, pos{pos} { settle(); }
+    };
+};
+
+/* BGL free functions, found by argument-dependent lookup */
+
+inline std::pair<boost::counting_iterator<std::size_t>, boost::counting_iterator<std::size_t>>
+vertices(const CompactOrbitGraph& g) {
+    return {boost::counting_iterator<std::size_t>(0),
+            boost::counting_iterator<std::size_t>(g.numvertices())};
+}
+
+inline std::size_t num_vertices(const CompactOrbitGraph& g) { return g.numvertices(); }
+inline std::size_t num_edges(const CompactOrbitGraph& g) { return g.numedges(); }
+
+inline std::pair<CompactOrbitGraph::out_edge_iterator, CompactOrbitGraph::out_edge_iterator>
+out_edges(std::size_t v, const CompactOrbitGraph& g) {
+    return {CompactOrbitGraph::out_edge_iterator(v, g.adjbegin(v)),
+            CompactOrbitGraph::out_edge_iterator(v, g.adjend(v))};
+}
+
+inline std::size_t out_degree(std::size_t v, const CompactOrbitGraph& g) {
+    return g.adjend(v) - g.adjbegin(v);
+}
+
+inline std::pair<CompactOrbitGraph::edge_iterator, CompactOrbitGraph::edge_iterator>
+edges(const CompactOrbitGraph& g) {
+    return {CompactOrbitGraph::edge_iterator(&g, 0, 0),
+            CompactOrbitGraph::edge_iterator(&g, g.numvertices(), 2*g.numedges())};
+}
+
+inline std::size_t source(const CompactOrbitGraph::edge& e, const CompactOrbitGraph&) {
+    return e.from;
+}
+
+inline std::size_t target(const CompactOrbitGraph::edge& e, const CompactOrbitGraph&) {
+    return CompactOrbitGraph::neighbour(e.entry);
+}
+
+namespace boost {
+    template <>
+    struct graph_traits<CompactOrbitGraph> {
+        struct traversal_category : incidence_graph_tag, vertex_list_graph_tag,
+                                    edge_list_graph_tag {};
+        typedef std::size_t vertex_descriptor;
+        typedef CompactOrbitGraph::edge edge_descriptor;
+        typedef undirected_tag directed_category;
+        typedef disallow_parallel_edge_tag edge_parallel_category;
+        typedef counting_iterator<std::size_t> vertex_iterator;
+        typedef CompactOrbitGraph::out_edge_iterator out_edge_iterator;
+        typedef CompactOrbitGraph::edge_iterator edge_iterator;
+        typedef std::size_t vertices_size_type;
+        typedef std::size_t edges_size_type;
+        typedef std::size_t degree_size_type;
+        static vertex_descriptor null_vertex() { return ~std::size_t{0}; }
+    };
+}
+
+/* Bulk builds of either kind of orbit graph, from orbitedges */
+OrbitGraph makeOrbit(const HasseDiagram& hasse, unsigned nthreads = 1);
+CompactOrbitGraph makeCompactOrbit(const HasseDiagram& hasse, unsigned nthreads = 1);
+
+/* The same TikZ graph for either one */
+TeXout& operator<<(TeXout& tex, const OrbitGraph& og);
+TeXout& operator<<(TeXout& tex, const CompactOrbitGraph& og);
+
+#endif // NAM_ORBITGRAPH_H
@@ -0,0 +1,29 @@
+#ifndef NAM_PARALLEL_H
+#define NAM_PARALLEL_H
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/* Fork-join loop: split [0, n) into nthreads contiguous blocks, in order,
+ * and call f(begin, end, t) for block t, each on its own thread
+ * (block 0 runs on the calling thread). Returns when all blocks are done.
+ * With one thread, this is just f(0, n, 0). */
+template <typename F>
+void parallel_for(unsigned nthreads, std::size_t n, F f) {
+    if (nthreads > n)
+        nthreads = n;
+    if (nthreads <= 1) {
+        f(std::size_t{0}, n, 0u);
+        return;
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(nthreads - 1);
+    for (unsigned t = 1; t < nthreads; ++t)
+        pool.emplace_back(f, n*t/nthreads, n*(t + 1)/nthreads, t);
+    f(std::size_t{0}, n/nthreads, 0u);
+    for (auto& th : pool)
+        th.join();
+}
+
+#endif // NAM_PARALLEL_H
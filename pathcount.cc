@@ -0,0 +1,151 @@
+#include "pathcount.h"
+#include <algorithm> // min, mismatch
+#include <stdexcept>
+
+using std::vector;
+using std::size_t;
+using boost::num_vertices;
+
+PathCount::PathCount(const vector<bool>& ringed)
+  : lit{0}, chains{{1}}, state{{counted}}, pascal{{1}} {
+    assign(ringed);
+}
+
+void PathCount::assign(const vector<bool>& ringed) {
+    // the intervals ending by node p (the end of what is the same) stay
+    const size_t p = ringed.size() < ring.size() ? ringed.size() : ring.size();
+    const size_t same = std::mismatch(ring.begin(), ring.begin() + p, ringed.begin()).first - ring.begin();
+    ring = ringed;
+    lit.resize(same + 1);
+    chains.resize(same + 1);
+    state.resize(same + 1);
+    for (size_t j = same + 1; j <= ring.size(); ++j) {
+        lit.push_back(lit.back() + ring[j - 1]);
+        chains.emplace_back(j + 1);
+        state.emplace_back(j + 1, unknown);
+        chains[j][j] = 1; // the empty interval
+        state[j][j] = counted;
+    }
+    // Pascal's triangle, each row (by symmetry) up to the middle, or to the
+    // first entry which doesn't fit
+    for (size_t m = pascal.size(); m <= ring.size(); ++m) {
+        const vector<Count128>& above = pascal[m - 1];
+        vector<Count128> row{1};
+        try {
+            for (size_t k = 1; 2*k <= m; ++k) {
+                const size_t left = k - 1, right = std::min(k, m - 1 - k);
+                if (right >= above.size())
+                    break;
+                row.push_back(above[left] + above[right]);
+            }
+        } catch (const std::overflow_error&) {
+            // the rest of the row is too big as well
+        }
+        pascal.push_back(std::move(row));
+    }
+}
+
+Count128 PathCount::choose(size_t n, size_t k) const {
+    k = std::min(k, n - k);
+    if (k >= pascal[n].size())
+        throw std::overflow_error("Count does not fit in 128 bits.");
+    return pascal[n][k];
+}
+
+Count128 PathCount::chainsbelow(size_t i, size_t j) {
+    if (state[j][i] == counted)
+        return chains[j][i];
+    if (state[j][i] == toobig)
+        throw std::overflow_error("Count does not fit in 128 bits.");
+    Count128 f = 0;
+    try {
+        for (size_t k = i; k < j && lit[j] != lit[i]; ++k) {
+            const Count128 below = chainsbelow(i, k);
+            if (below == 0)
+                continue;
+            const Count128 above = chainsbelow(k + 1, j);
+            if (above != 0)
+                f += choose(j - i - 1, k - i) * below * above;
+        }
+    } catch (const std::overflow_error&) {
+        state[j][i] = toobig; // so as not to work it out again
+        throw;
+    }
+    chains[j][i] = f;
+    state[j][i] = counted;
+    return f;
+}
+
+Count128 PathCount::flagorbits(size_t begin, size_t end) {
+    if (begin > end || end > size())
+        throw std::out_of_range("PathCount: no such stretch of the path");
+    if (lit[end] == lit[begin])
+        return 1; // no faces but the empty set
+    return chainsbelow(begin, end);
+}
+
+vector<Count128> PathCount::faces(size_t begin, size_t end) const {
+    if (begin > end || end > size())
+        throw std::out_of_range("PathCount: no such stretch of the path");
+    // The sets of the nodes so far, by size: those which end with a node
+    // left out, with an interval having a ringed node, or with one which
+    // hasn't (yet). The last kind is dropped once there are no more ringed
+    // nodes to come, so every count here is at most a count of faces.
+    const size_t n = end - begin;
+    vector<Count128> out(n + 1), done(n + 1), open(n + 1);
+    out[0] = 1;
+    for (size_t v = begin; v < end; ++v) {
+        const bool more = lit[end] != lit[v + 1]; // ringed nodes after v
+        for (size_t r = v - begin + 1; r > 0; --r) {
+            const Count128 closed = out[r] + done[r];
+            if (ring[v]) {
+                done[r] = out[r - 1] + done[r - 1] + open[r - 1];
+                open[r] = 0;
+            } else {
+                done[r] = done[r - 1];
+                open[r] = more ? out[r - 1] + open[r - 1] : 0;
+            }
+            out[r] = closed;
+        }
+        out[0] = 1; // the empty set
+    }
+    for (size_t r = 0; r <= n; ++r)
+        out[r] += done[r];
+    return out;
+}
+
+vector<vsize_t> pathorder(const CoxeterGraph& cg) {
+    const vsize_t n = num_vertices(cg);
+    if (n == 0 || num_edges(cg) != n - 1)
+        return {};
+    vsize_t start = n;
+    for (vsize_t v = 0; v < n; ++v) {
+        if (out_degree(v, cg) > 2 || edge(v, v, cg).second)
+            return {};
+        if (start == n && out_degree(v, cg) < 2)
+            start = v;
+    }
+    // go along from start; with n - 1 edges, it's a path if that reaches
+    // every node
+    vector<vsize_t> order{start};
+    for (vsize_t prev = n, v = start; order.size() < n; ) {
+        vsize_t next = n;
+        for (auto w : boost::make_iterator_range(adjacent_vertices(v, cg))) {
+            if (w != prev)
+                next = w;
+        }
+        if (next == n)
+            return {};
+        order.push_back(next);
+        prev = v;
+        v = next;
+    }
+    return order;
+}
+
+vector<bool> pathringing(const CoxeterGraph& cg, const vector<vsize_t>& order) {
+    vector<bool> ringed;
+    for (auto v : order)
+        ringed.push_back(cg[v].ringed);
+    return ringed;
+}
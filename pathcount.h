@@ -0,0 +1,74 @@
+#ifndef NAM_PATHCOUNT_H
+#define NAM_PATHCOUNT_H
+
+#include <cstddef>
+#include <vector>
+#include "coxeter.h"
+#include "count128.h"
+
+/*************
+ * PathCount *
+ *************/
+
+/* Counts for path-shaped diagrams (A_n, B_n, H_n, linear_coxeter, ...)
+ * worked out from the ringing alone, with no subsets at all.
+ *
+ * On a path every subdiagram is a row of intervals, and it is a face
+ * exactly when every interval has a ringed node; the edge orders don't
+ * come into it. The top step of a chain down from an interval drops one
+ * of its nodes, k, leaving the intervals to either side; the rest of the
+ * chain interleaves a chain from each. So with f(i, j) the chains below
+ * the interval of nodes i, ..., j - 1 (1 if it is empty, 0 if it has no
+ * ringed node),
+ *   f(i, j) = sum over k of (j - i - 1 choose k - i) f(i, k) f(k + 1, j),
+ * which is O(n) per interval and O(n^3) for the whole path.
+ *
+ * The intervals are worked out when first needed and then kept, so the
+ * counts of any stretch of the path, or of paths which start the same way,
+ * share them: one long path holds every row of a table such as countonly's.
+ * The counts throw std::overflow_error only if the answer asked for doesn't
+ * fit in a Count128 (a chain below any face extends to one of the whole). */
+class PathCount {
+    std::vector<bool> ring;
+    std::vector<std::size_t> lit; // lit[i] is the number ringed before node i
+    enum : char { unknown, counted, toobig };
+    std::vector<std::vector<Count128>> chains; // chains[j][i] is f(i, j),
+    std::vector<std::vector<char>> state;      // once state[j][i] is counted
+    std::vector<std::vector<Count128>> pascal; // binomials, each row up to the
+                                               // first too big for a Count128
+    Count128 choose(std::size_t n, std::size_t k) const;
+    Count128 chainsbelow(std::size_t i, std::size_t j); // f(i, j), worked out if need be
+
+    public:
+    /* The path with node i ringed when ringed[i] is */
+    explicit PathCount(const std::vector<bool>& ringed = {});
+
+    std::size_t size() const { return ring.size(); }
+
+    /* Change to the path with this ringing. What is known is kept if the
+     * old path is the start of the new one, as when a family grows a node
+     * at a time. */
+    void assign(const std::vector<bool>& ringed);
+
+    /* The number of flag orbits of the path of nodes begin, ..., end - 1:
+     * FaceOrbitPoset{cg}.head->numpaths(), for cg that stretch of the path
+     * with its ringing. */
+    Count128 flagorbits(std::size_t begin, std::size_t end);
+    Count128 flagorbits() { return flagorbits(0, size()); }
+
+    /* The number of faces of each rank of the same stretch: entry r is the
+     * number of sets of r of its nodes with a ringed node in every
+     * interval. With no node ringed, only the empty set is a face. */
+    std::vector<Count128> faces(std::size_t begin, std::size_t end) const;
+    std::vector<Count128> faces() const { return faces(0, size()); }
+};
+
+/* The nodes of cg in order along it, starting from the end with the lower
+ * number, if cg is a path: connected, with no loops, branches, or cycles.
+ * Otherwise, the empty vector. */
+std::vector<vsize_t> pathorder(const CoxeterGraph& cg);
+
+/* Which of the nodes in order are ringed: entry i for node order[i] */
+std::vector<bool> pathringing(const CoxeterGraph& cg, const std::vector<vsize_t>& order);
+
+#endif // NAM_PATHCOUNT_H
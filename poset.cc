@@ -1,213 +1,219 @@
 #include "poset.h"
 #include <algorithm>
-#include <numeric> // accumulate
-#include <cmath> // log2
-#include <experimental/optional>
+#include <numeric> // iota
+#include <mutex>
 #include "TeXout.h"
+#include "parallel.h"
 
 using std::vector;
-using std::max;
 using boost::num_vertices;
-typedef CoxeterGraph::vertex_descriptor Vertex; // it's std::size_t
 
 
 /*********************
  * Utility functions *
  *********************/
 namespace {
-    /* If containers a and b differ at exactly one index, return that index. */
-    template <typename V>
-    std::experimental::optional<int> diffinone(V a, V b) {
-        if (a.size() != b.size())
-            return {};
-        bool differ = false;
-        int m = -1;
-        for (size_t i = 0; i < a.size(); ++i) {
-            if (a[i] != b[i]) {
-                if (differ) return {};
-                differ = true;
-                m = i;
+    /* (parent id, child id) for an edge of the Hasse diagram */
+    typedef std::pair<std::uint32_t, std::uint32_t> Link;
+
+    /* Fill in rank r - 1 (below) from rank r (above), recording the links
+     * between them in the order they are found. */
+    void genrank(const RankLayer& above, RankLayer& below, const BitDiagram& bd,
+                 vector<Link>& links) {
+        for (std::uint32_t p = 0; p < above.size(); ++p) {
+            const PosetNode& pn = above[p];
+            // Try dropping each vertex in turn, and check if there
+            // is a ringed node in every connected component.
+            for (nodemask rest = pn.mask; rest; rest &= rest - 1) {
+                const nodemask kidmask = pn.mask & ~(rest & -rest);
+                if (!bd.allringed(kidmask))
+                    continue;
+                // if the mask is already present, this just finds it.
+                auto kid = below.insert(kidmask);
+                links.push_back({p, kid.first});
             }
         }
-        if (differ) return m;
-        return {};
     }
 
-    /* Find the range of a (numeric) vertex property on a graph */
-    template <typename PropMap>
-    int proprange(const PropMap& p) {
-        auto vits = boost::vertices(*p.m_g); 
-        auto mnmx = std::minmax_element(vits.first, vits.second,
-                [&p](Vertex a, Vertex b) {
-                    return get(p, a) < get(p, b);
-                });
-        return get(p, *mnmx.second) - get(p, *mnmx.first);
-    }
+    /* Fewest parents worth handing to a thread of their own */
+    constexpr std::size_t minparents = 64;
+
+    /* genrank, with the parents split among nthreads threads.
+     * The children are deduplicated concurrently into shards, each with
+     * its own lock and MaskIndex, and then gathered into below.
+     * Each thread takes a contiguous block of parents, so the links
+     * come out in exactly the order genrank would give. */
+    void genrank_parallel(const RankLayer& above, RankLayer& below, const BitDiagram& bd,
+                          vector<Link>& links, unsigned nthreads) {
+        struct Shard {
+            std::mutex lock;
+            MaskIndex index;
+            vector<nodemask> masks;
+        };
+        struct ShardLink {
+            std::uint32_t parent, shard, id;
+        };
+        unsigned shardbits = 2;
+        while ((1u << shardbits) < 8*nthreads)
+            ++shardbits;
+        vector<Shard> shards(1u << shardbits);
+        vector<vector<ShardLink>> found(nthreads);
+
+        parallel_for(nthreads, above.size(), [&](std::size_t b, std::size_t e, unsigned t) {
+            for (std::uint32_t p = b; p < e; ++p) {
+                const PosetNode& pn = above[p];
+                for (nodemask rest = pn.mask; rest; rest &= rest - 1) {
+                    const nodemask kidmask = pn.mask & ~(rest & -rest);
+                    if (!bd.allringed(kidmask))
+                        continue;
+                    // a different hash from MaskIndex's, so each shard's
+                    // masks still spread out over its own table
+                    const std::uint32_t s = (kidmask * UINT64_C(0xff51afd7ed558ccd))
+                                                >> (64 - shardbits);
+                    Shard& sh = shards[s];
+                    std::lock_guard<std::mutex> hold{sh.lock};
+                    auto kid = sh.index.insert(kidmask);
+                    if (kid.second)
+                        sh.masks.push_back(kidmask);
+                    found[t].push_back({p, s, kid.first});
+                }
+            }
+        });
 
-    const PosetNode& inserter(std::set<PosetNode>& s, bitset&& b, const CoxeterGraph& cg) {
-        return *(s.insert({std::move(b), cg, {}, {}}).first);
+        vector<std::uint32_t> offset(shards.size());
+        for (std::size_t s = 0; s < shards.size(); ++s) {
+            offset[s] = below.size();
+            for (auto m : shards[s].masks)
+                below.insert(m);
+        }
+        for (const auto& f : found) {
+            for (const auto& l : f)
+                links.push_back({l.parent, offset[l.shard] + l.id});
+        }
     }
 }
 
 /*************
- * PosetNode *
+ * RankLayer *
  *************/
- 
-int PosetNode::numpaths() const {
-    // The number of paths leading down from this node
-    if (children.empty())
-        return 1;
-    int sum{0};
-    for (auto kid : children) {
-        sum += kid->numpaths();
-    }
-    return sum;
-}
 
-vector<vector<const PosetNode*>> PosetNode::chains() const {
-    if (children.empty())
-        return { { this } };
-    vector<vector<const PosetNode*>> chains;
-    for (auto kid : children) {
-        auto kidchains = kid->chains();
-        for (size_t i = 0; i < kidchains.size(); ++i)
-            kidchains[i].push_back(this);
-        chains.insert(chains.end(), kidchains.begin(), kidchains.end());
+vector<std::uint32_t> RankLayer::canonicalize() {
+    vector<std::uint32_t> order(nds.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) {
+                                              return nds[a].mask < nds[b].mask; });
+    vector<std::uint32_t> newid(nds.size());
+    vector<PosetNode> sorted;
+    sorted.reserve(nds.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        newid[order[i]] = i;
+        sorted.push_back(std::move(nds[order[i]]));
     }
-    return chains;
-}
-
-double PosetNode::x_avg() const {
-    /* the average of the x-coordinates of the dots in the Coxeter diagram
-     * which are included in the subgraph. For use positioning this node
-     * in the Hasse diagram. */
-    double sum = 0.0;
-    auto vits = boost::vertices(cg);
-    for (auto vit = vits.first; vit != vits.second; ++vit)
-        sum += cg[*vit].x_coord;
-    return sum/num_vertices(cg);
-}
-
-std::array<double,6> PosetNode::x_tuple() const {
-    return {x_avg(),
-        std::accumulate(parents.begin(), parents.end(), 0.0,
-                [](double sum, const PosetNode* p){ return sum + p->x_avg(); })/parents.size(),
-        std::accumulate(children.begin(), children.end(), 0.0,
-                [](double sum, const PosetNode* p){ return sum + p->x_avg(); })/children.size(),
-        (*std::min_element(parents.begin(), parents.end(),
-                [](const PosetNode* a, const PosetNode* b){
-                    return a->x_avg() < b->x_avg();
-                }))->x_avg(),
-        (*std::min_element(children.begin(), children.end(),
-                [](const PosetNode* a, const PosetNode* b){
-                    return a->x_avg() < b->x_avg();
-                }))->x_avg(),
-        static_cast<double>(cg[0].x_coord)}; //should be the least x_coord
+    nds.swap(sorted);
+    index.clear();
+    for (const auto& pn : nds)
+        index.insert(pn.mask);
+    return newid;
 }
 
 /******************
  * FaceOrbitPoset *
  ******************/
 
-FaceOrbitPoset::FaceOrbitPoset(const CoxeterGraph& cg) :
-  nodes(num_vertices(cg) + 1),
-  head{&inserter(nodes.back(), std::move(bitset{num_vertices(cg)}.set()), cg)} {
-    genchildren();
+FaceOrbitPoset::FaceOrbitPoset(const CoxeterGraph& cg, unsigned nthreads) : head{nullptr} {
+    build(cg, nthreads);
+}
+
+void FaceOrbitPoset::build(const CoxeterGraph& cg, unsigned nthreads) {
+    const BitDiagram bd{cg}; // this checks that cg is small enough
+    this->cg = cg;
+    head = nullptr;
+    for (auto& layer : nodes)
+        layer.clear();
+    nodes.resize(num_vertices(cg) + 1);
+    arena.reset();
+    head = &nodes.back()[nodes.back().insert(bd.all()).first];
+    genchildren(nthreads);
+    countpaths();
 }
 
-void FaceOrbitPoset::genchildren() {
+void FaceOrbitPoset::genchildren(unsigned nthreads) {
+    const BitDiagram bd{cg};
+    vector<Link> links;
+    vector<std::uint32_t> nkids, nparents;
     for (int r = nodes.size() - 1; r > 0; --r) {
-        for (auto& pn : nodes[r]) {
-            // Try dropping each vertex in turn, and check if there
-            // is a ringed node in every connected component.
-            auto overt = pn.bs.find_first();
-            auto vits = boost::vertices(pn.cg);
-            for (auto v = vits.first; v != vits.second; ++v) {
-                CoxeterGraph kid { pn.cg };
-                boost::clear_vertex(*v, kid); //remove all edges to v
-                boost::remove_vertex(*v, kid);
-                if (allringed(kid)) {
-                    const PosetNode& kidnode = inserter(nodes[r-1],
-                             std::move(bitset{pn.bs}.reset(overt)), // clear bit overt
-                                                              kid);
-                    // if the bitset is already present, just add this parent
-                    // to the existing node.
-                    kidnode.parents.push_back(&pn);
-                    pn.children.push_back(&kidnode);
-                }
-                overt = pn.bs.find_next(overt);
-            }
+        RankLayer& above = nodes[r];
+        RankLayer& below = nodes[r-1];
+        links.clear();
+        const unsigned threads = std::min<std::size_t>(nthreads, above.size()/minparents);
+        if (threads > 1)
+            genrank_parallel(above, below, bd, links, threads);
+        else
+            genrank(above, below, bd, links);
+        // rank r - 1 is complete, so its nodes can be put in order and linked.
+        // Between them, the links found here are all the children of rank r
+        // and all the parents of rank r - 1, so each node's span can be
+        // sized exactly before it is filled.
+        const auto newid = below.canonicalize();
+        nkids.assign(above.size(), 0);
+        nparents.assign(below.size(), 0);
+        for (const auto& l : links) {
+            ++nkids[l.first];
+            ++nparents[newid[l.second]];
+        }
+        const PosetNode** room = arena.allocate<const PosetNode*>(links.size());
+        for (std::size_t i = 0; i < above.size(); ++i) {
+            above[i].children = LinkSpan{room};
+            room += nkids[i];
+        }
+        room = arena.allocate<const PosetNode*>(links.size());
+        for (std::size_t i = 0; i < below.size(); ++i) {
+            below[i].parents = LinkSpan{room};
+            room += nparents[i];
+        }
+        for (const auto& l : links) {
+            PosetNode& pn = above[l.first];
+            PosetNode& kid = below[newid[l.second]];
+            pn.children.push_back(&kid);
+            kid.parents.push_back(&pn);
         }
     }
 }
 
-void FaceOrbitPoset::to_tikz(TeXout& tex) const {
-    const double width = proprange(get(&VertexProps::x_coord, head->cg));
-    const double height = proprange(get(&VertexProps::y_coord, head->cg));
-    // separation between the nodes:
-    const double sep = width < 2.0 ? 1.0 : 1.5;
-    const double yscale = max(height + 0.5, std::log2(max(2.0, width)));
-
-    for (int y = nodes.size() - 1; y >= 0; --y) {
-        const int num = nodes[y].size();
-        vector<const PosetNode*> nds(num);
-        std::transform(nodes[y].begin(), nodes[y].end(), nds.begin(),
-                       [](const PosetNode& p){ return &p; });
-        std::sort(nds.begin(), nds.end(), [](const PosetNode* a, const PosetNode* b)
-                                            { return a->x_tuple() < b->x_tuple(); });
-        for (size_t i = 0; i < nds.size(); ++i) {
-            const double xpos = (width + sep)*(i - (num - 1)/2.0);
-            tex << "\\node[draw] (n" << nds[i]->bs
-                << ") at (" << xpos
-                << ", " << y*yscale << ") {\n"
-                << env_wrap{"tikzpicture"} << nds[i]->cg
-                << "};\n";
-            for (auto p : nds[i]->parents) {
-                tex << "\\draw (n" << p->bs << ") -- (n" << nds[i]->bs << ");\n";
+void FaceOrbitPoset::countpaths() {
+    // Bottom-up, so each node's children are already counted:
+    // one visit per node and one addition per edge of the Hasse diagram.
+    for (auto& rank : nodes) {
+        for (auto& pn : rank) {
+            if (pn.children.empty()) {
+                pn.paths = 1;
+                continue;
             }
+            pn.paths = 0;
+            for (auto kid : pn.children)
+                pn.paths += kid->paths;
         }
     }
 }
 
-OrbitGraph makeOrbit(const FaceOrbitPoset& hasse) {
-    auto flagorbs = hasse.head->chains();
-    OrbitGraph og {flagorbs.size()};
-    // for each pair of chains in flagorbs that differ in exactly
-    // the i-th entry, add an edge labeled i
-    for (size_t i = 0; i < flagorbs.size(); ++i) {
-        for (size_t j = i+1; j < flagorbs.size(); ++j) {
-            auto difrank = diffinone(flagorbs[i], flagorbs[j]);
-            if (difrank)
-                boost::add_edge(i, j, {*difrank}, og);
+HasseDiagram FaceOrbitPoset::freeze() const {
+    // ids go by rank, and by mask within each rank, which is just
+    // the order of the layers
+    vector<std::uint32_t> base(nodes.size() + 1, 0);
+    for (std::size_t r = 0; r < nodes.size(); ++r)
+        base[r + 1] = base[r] + nodes[r].size();
+    vector<nodemask> masks;
+    vector<std::uint32_t> downstart{0};
+    vector<HasseDiagram::nodeid> downs;
+    masks.reserve(base.back());
+    downstart.reserve(base.back() + 1);
+    for (std::size_t r = 0; r < nodes.size(); ++r) {
+        for (const auto& pn : nodes[r]) {
+            masks.push_back(pn.mask);
+            for (auto kid : pn.children) // kid is in layer r - 1
+                downs.push_back(base[r - 1] + (kid - &nodes[r - 1][0]));
+            downstart.push_back(downs.size());
         }
     }
-    return og;
+    return {cg, std::move(masks), std::move(downstart), std::move(downs)};
 }
-
-TeXout& operator<<(TeXout& tex, const OrbitGraph& og) {
-    static bool inited {false};
-
-    if (!inited) {
-        tex.usepackage("tikz");
-        tex.usetikzlibrary("graphs");
-        tex.usetikzlibrary("graphdrawing");
-        tex.usetikzlibrary("quotes");
-        tex.addtopreamble("\\usegdlibrary{force}\n");
-        tex.addtopreamble("\\tikzset{\n"
-            "  graphs/edges={inner sep=1pt},\n"
-            "  graphs/nodes={fill,circle,inner sep=1.6pt}\n"
-            "}\n");
-        inited = true;
-    }
-
-    auto edgits = boost::edges(og);
-    if (edgits.first == edgits.second)
-        return tex;
-    tex << "\\graph[spring electrical layout,horizontal= 0 to 1] {\n";
-    for (auto eit = edgits.first; eit != edgits.second; ++eit) {
-        tex << boost::source(*eit, og) << "/ --[\"" << og[*eit].rank
-            << "\"] " << boost::target(*eit, og) << "/;\n";
-    }
-    return tex << "};\n";
-}
-
@@ -2,41 +2,107 @@
 #define NAM_POSET_H
 
 #include <vector>
-#include <set>
-#include <array>
-#include <boost/dynamic_bitset.hpp>
+#include <cstdint>
 #include "coxeter.h" // includes <boost/graph/adjacency_list.hpp> and forward-declares TeXout
+#include "bitdiagram.h" // nodemask
+#include "maskindex.h"
+#include "count128.h"
+#include "arena.h"
+#include "hassediagram.h"
 
-typedef boost::dynamic_bitset<> bitset;
+struct PosetNode;
+
+/************
+ * LinkSpan *
+ ************/
+
+/* The parents or children of a PosetNode: a run of pointers in the
+ * poset's arena, sized exactly once all the links are known. */
+class LinkSpan {
+    const PosetNode** first;
+    std::uint32_t n;
+
+    public:
+    typedef const PosetNode* const* const_iterator;
+
+    LinkSpan() : first{nullptr}, n{0} {}
+    /* Empty, with room for as many links as have been allocated at room */
+    explicit LinkSpan(const PosetNode** room) : first{room}, n{0} {}
+
+    /* There must be room left for p */
+    void push_back(const PosetNode* p) { first[n++] = p; }
+
+    std::size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    const PosetNode* operator[](std::size_t i) const { return first[i]; }
+    const_iterator begin() const { return first; }
+    const_iterator end() const { return first + n; }
+};
 
 /*************
  * PosetNode *
  *************/
 
 struct PosetNode {
-    bitset bs;
-    /* The bitset keeps track of which dots of the original CoxeterGraph
-     * (the top-rank node in the poset)
-     * are present in this subgraph. Really, this should be all the information
-     * needed, but we keep the CoxeterGraph object to use for boost::graph
-     * algorithms like connected_components */
-    CoxeterGraph cg;
-    mutable std::vector<const PosetNode*> parents;
-    mutable std::vector<const PosetNode*> children;
-    /* We keep the PosetNodes in std::sets to find duplicate subgraphs.
-     * That forces them to be const. But we want to change the parents and
-     * children, which doesn't affect the bitset, which is used for the ordering.
-     * So they're marked mutable. */
+    nodemask mask;
+    /* The mask keeps track of which dots of the poset's diagram
+     * (FaceOrbitPoset::cg, the top-rank node) are present in this face.
+     * That is all the information needed; anything drawn is drawn from the
+     * one diagram, through a SubDiagram. */
+    LinkSpan parents;
+    LinkSpan children;
+    Count128 paths;
+    /* The number of paths leading down from this node, filled in by
+     * FaceOrbitPoset::countpaths once the poset is built. */
  
-    int numpaths() const;
-    std::vector<std::vector<const PosetNode*>> chains() const;
-    
-    double x_avg() const;
-    std::array<double,6> x_tuple() const;
-
-    bool operator< (const PosetNode& other) const {
-        return bs < other.bs;
+    Count128 numpaths() const { return paths; }
+};
+
+/*************
+ * RankLayer *
+ *************/
+
+/* The PosetNodes of one rank, in a dense array, so they can be referred to
+ * by integer id, with a MaskIndex to find them by mask in amortized O(1).
+ * Ids are handed out in order of insertion; canonicalize() then sorts the
+ * layer by mask, so the order doesn't depend on how the layer was built.
+ * Once a layer is finished it doesn't move, and pointers into it are stable. */
+class RankLayer {
+    std::vector<PosetNode> nds;
+    MaskIndex index;
+
+    public:
+    typedef std::vector<PosetNode>::iterator iterator;
+    typedef std::vector<PosetNode>::const_iterator const_iterator;
+
+    /* Find the node with mask m, adding it if necessary.
+     * Returns its id, and whether it is new. */
+    std::pair<std::uint32_t, bool> insert(nodemask m) {
+        auto ins = index.insert(m);
+        if (ins.second)
+            nds.push_back({m, {}, {}, {}});
+        return ins;
     }
+
+    /* The id of the node with mask m, or MaskIndex::npos */
+    std::uint32_t find(nodemask m) const { return index.find(m); }
+
+    /* Sort the nodes by mask, returning the new id of each old id */
+    std::vector<std::uint32_t> canonicalize();
+
+    /* Remove all the nodes, keeping the storage */
+    void clear() {
+        nds.clear();
+        index.clear();
+    }
+
+    std::size_t size() const { return nds.size(); }
+    PosetNode& operator[](std::size_t i) { return nds[i]; }
+    const PosetNode& operator[](std::size_t i) const { return nds[i]; }
+    iterator begin() { return nds.begin(); }
+    iterator end() { return nds.end(); }
+    const_iterator begin() const { return nds.begin(); }
+    const_iterator end() const { return nds.end(); }
 };
 
 /******************
@@ -44,12 +110,31 @@ struct PosetNode {
  ******************/
 
 struct FaceOrbitPoset {
-    std::vector<std::set<PosetNode>> nodes;
+    CoxeterGraph cg; // the whole diagram; each node is a subset of its nodes
+    std::vector<RankLayer> nodes; // nodes[r] holds the faces of rank r
     const PosetNode* head;
+    PosetArena arena; // the parent and child links of all the nodes
+
+    /* An empty poset (head is null), to be built later */
+    FaceOrbitPoset() : head{nullptr} {}
+
+    /* Throws std::length_error if cg has more than BitDiagram::maxnodes nodes.
+     * With nthreads > 1, the children of each rank are generated in parallel;
+     * the result is the same either way. */
+    FaceOrbitPoset(const CoxeterGraph& cg, unsigned nthreads = 1);
+
+    /* Replace the poset with that of cg, reusing the storage of the old one
+     * (its arena blocks and rank layers), so repeated builds allocate
+     * next to nothing. */
+    void build(const CoxeterGraph& cg, unsigned nthreads = 1);
 
-    FaceOrbitPoset(const CoxeterGraph& cg);
-    void genchildren();
-    void to_tikz(TeXout& tex) const;
+    void genchildren(unsigned nthreads = 1);
+    void countpaths();
+
+    /* The finished poset in compressed sparse rows, for analysis */
+    HasseDiagram freeze() const;
+
+    void to_tikz(TeXout& tex) const { freeze().to_tikz(tex); }
 };
 
 inline TeXout& operator<<(TeXout& tex, const FaceOrbitPoset& fop) {
@@ -57,22 +142,4 @@ inline TeXout& operator<<(TeXout& tex, const FaceOrbitPoset& fop) {
     return tex;
 }
 
-/*** Orbit Graphs ***/
-/* These should logically be in their own header, but there are only four
- * lines here */
-
-struct EdgeRank {
-    int rank;
-};
-
-typedef boost::adjacency_list<boost::vecS, //container for edges at each vertex (vector)
-                              boost::vecS, //container for the vertices (vector)
-                              boost::undirectedS,
-                              boost::no_property, //no vertex properties
-                              EdgeRank> // edges have rank
-                              OrbitGraph;
-
-OrbitGraph makeOrbit(const FaceOrbitPoset& hasse);
-TeXout& operator<<(TeXout& tex, const OrbitGraph& og);
-
 #endif // NAM_POSET_H
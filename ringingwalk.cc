@@ -0,0 +1,176 @@
+#include "ringingwalk.h"
+#include <algorithm> // sort
+#include <stdexcept>
+
+using std::vector;
+using boost::num_vertices;
+typedef HasseDiagram::nodeid nodeid;
+
+RingingWalk::RingingWalk(const CoxeterGraph& cg)
+  : cg(cg), table{cg}, nchanged{0} {
+    const vsize_t n = num_vertices(cg);
+    const BitDiagram bd{cg};
+    all = bd.all();
+    ring = bd.ringed();
+    for (vsize_t v = 0; v < n; ++v) {
+        place.push_back(v);
+        slot.push_back(v);
+    }
+    faces.assign(((std::size_t{1} << n) + 63)/64, 0);
+    links.assign(std::size_t{1} << n, 0);
+    chains.assign(std::size_t{1} << n, 0);
+    for (nodemask s = 0; s <= all; ++s)
+        update(s);
+    nchanged = 0;
+}
+
+nodemask RingingWalk::inner(nodemask m) const {
+    nodemask in = 0;
+    for (; m; m &= m - 1)
+        in |= nodebit(slot[lownode(m)]);
+    return in;
+}
+
+nodemask RingingWalk::outer(nodemask m) const {
+    nodemask out = 0;
+    for (; m; m &= m - 1)
+        out |= nodebit(place[lownode(m)]);
+    return out;
+}
+
+void RingingWalk::update(nodemask s) {
+    if (table.isface(s, ring) != face(s)) {
+        faces[s >> 6] ^= std::uint64_t{1} << (s & 63u);
+        ++nchanged;
+    }
+    // Only the faces and the head are in the poset; what is kept for the
+    // other sets is never read. A set with nothing below is a bottom, with
+    // the one chain, as in HasseDiagram::numpaths.
+    std::uint32_t down = 0;
+    Count128 below = 0;
+    if (face(s) || s == all) {
+        for (nodemask rest = s; rest; rest &= rest - 1) {
+            const nodemask kid = s & ~nodebit(lownode(rest));
+            if (face(kid)) {
+                down |= std::uint32_t{1} << lownode(rest);
+                below += chains[kid];
+            }
+        }
+    }
+    links[s] = down;
+    chains[s] = down ? below : 1;
+}
+
+void RingingWalk::flip(vsize_t u) {
+    ring ^= nodebit(u);
+    cg[place[u]].ringed = !cg[place[u]].ringed;
+    nchanged = 0;
+    // every subset of the other nodes, with u added, in increasing order
+    const nodemask others = all & ~nodebit(u);
+    nodemask t = 0;
+    do {
+        update(t | nodebit(u));
+        t = (t - others) & others;
+    } while (t);
+}
+
+void RingingWalk::moveto(nodemask r) {
+    for (nodemask diff = inner(r & all) ^ ring; diff; diff &= diff - 1)
+        flip(lownode(diff));
+}
+
+void RingingWalk::insertnode(const CoxeterGraph& grown, vsize_t v) {
+    const vsize_t n = num_vertices(cg);
+    if (num_vertices(grown) != n + 1 || v > n)
+        throw std::invalid_argument("RingingWalk: the new diagram must have one more node");
+    // node w of cg is node up(w) of grown, and node w != v of grown is
+    // node down(w) of cg
+    const auto up = [v](vsize_t w) { return w < v ? w : w + 1; };
+    const auto down = [v](vsize_t w) { return w < v ? w : w - 1; };
+    std::size_t kept = 0; // edges of grown away from v
+    nodemask neighbours = 0; // of v, in the order the nodes came
+    for (auto e : boost::make_iterator_range(edges(grown))) {
+        const vsize_t a = source(e, grown), b = target(e, grown);
+        if (a != v && b != v)
+            ++kept;
+        else if (a != b)
+            neighbours |= nodebit(slot[down(a == v ? b : a)]);
+    }
+    bool same = kept == num_edges(cg);
+    for (auto e : boost::make_iterator_range(edges(cg)))
+        same = same && edge(up(source(e, cg)), up(target(e, cg)), grown).second;
+    if (!same)
+        throw std::invalid_argument("RingingWalk: the new diagram isn't this one with a node put in");
+    table.addnode(neighbours);
+
+    for (auto& p : place) {
+        if (p >= v)
+            ++p;
+    }
+    place.push_back(v);
+    slot.assign(n + 1, 0);
+    for (vsize_t u = 0; u <= n; ++u)
+        slot[place[u]] = u;
+    const CoxeterGraph old = std::move(cg);
+    cg = grown;
+    for (vsize_t w = 0; w <= n; ++w)
+        cg[w].ringed = w != v && old[down(w)].ringed;
+
+    // The sets without the new node keep their components, and so whether
+    // they are faces; the rest are all new.
+    all = all << 1 | 1u;
+    faces.resize(((std::size_t{1} << (n + 1)) + 63)/64, 0);
+    links.resize(std::size_t{1} << (n + 1), 0);
+    chains.resize(std::size_t{1} << (n + 1), 0);
+    nchanged = 0;
+    for (nodemask s = nodebit(n); s <= all; ++s)
+        update(s);
+}
+
+HasseDiagram RingingWalk::freeze() const {
+    // Go down from the head, as FaceOrbitPoset does, dropping a node at a
+    // time; the faces which can't be reached that way aren't in the poset.
+    // Then number the nodes by rank and by mask, and link them.
+    // The masks here are cg's; each one's links are found once, and its
+    // children are the nodes in them.
+    const vsize_t n = num_vertices(cg);
+    const nodeid none = ~nodeid{0};
+    vector<nodeid> id(std::size_t{1} << n, none);
+    vector<vector<nodemask>> ranks(n + 1);
+    ranks[n].push_back(all);
+    id[all] = 0;
+    for (vsize_t r = n; r > 0; --r) {
+        for (auto s : ranks[r]) {
+            const std::uint32_t down = links[inner(s)];
+            for (nodemask rest = s; rest; rest &= rest - 1) {
+                const vsize_t v = lownode(rest);
+                const nodemask kid = s & ~nodebit(v);
+                if (down >> slot[v] & 1u && id[kid] == none) {
+                    id[kid] = 0;
+                    ranks[r - 1].push_back(kid);
+                }
+            }
+        }
+        std::sort(ranks[r - 1].begin(), ranks[r - 1].end());
+    }
+    vector<nodemask> masks;
+    for (const auto& rank : ranks) {
+        for (auto s : rank) {
+            id[s] = masks.size();
+            masks.push_back(s);
+        }
+    }
+    vector<std::uint32_t> downstart{0};
+    vector<nodeid> downs;
+    downstart.reserve(masks.size() + 1);
+    for (auto s : masks) {
+        const std::uint32_t down = links[inner(s)];
+        for (nodemask rest = s; rest; rest &= rest - 1) {
+            const vsize_t v = lownode(rest);
+            if (down >> slot[v] & 1u)
+                downs.push_back(id[s & ~nodebit(v)]);
+        }
+        downstart.push_back(downs.size());
+    }
+    return {cg, std::move(masks), std::move(downstart), std::move(downs)};
+}
@@ -0,0 +1,95 @@
+#ifndef NAM_RINGINGWALK_H
+#define NAM_RINGINGWALK_H
+
+#include <cstdint>
+#include <vector>
+#include "coxeter.h"
+#include "bitdiagram.h"
+#include "facetable.h"
+#include "hassediagram.h"
+#include "count128.h"
+
+/***************
+ * RingingWalk *
+ ***************/
+
+/* The faces of one Coxeter diagram under a ringing which changes one node
+ * at a time, with the links between them and the chains below each. Every
+ * subset's status (face or not) is kept in a bitmap, and for each face (and
+ * the whole diagram, the head) the nodes whose removal leaves a face below
+ * it, and the number of chains down from it through faces.
+ * Ringing or unringing node v changes none of these for the sets without v:
+ * their faces below don't contain v either. So toggle() goes through just
+ * the 2^(n-1) sets containing v, in increasing order, so that each one's
+ * faces below are done before it: it rechecks each against the FaceTable,
+ * then relinks it and adds up its chains. flagorbits() is then read off
+ * the head, and freeze() lays the links out as the same HasseDiagram as
+ * FaceOrbitPoset{cg}.freeze(), with no face tests.
+ * The diagram can also grow a node at a time, as through a family A_n,
+ * B_n, D_n, ...: insertnode() works out only the sets containing the new
+ * node. The table and the bitmap number the nodes in the order they came,
+ * so a node put in the middle of the diagram costs no more than one at
+ * the end; the masks taken and given are in the diagram's own numbering.
+ * The diagram can have at most FaceTable::maxnodes nodes. */
+class RingingWalk {
+    CoxeterGraph cg; // ringed as the walk is
+    FaceTable table; // these three in the order the nodes came
+    nodemask all;
+    nodemask ring;
+    std::vector<vsize_t> place; // place[u] is the node of cg which came u-th
+    std::vector<vsize_t> slot;  // and slot is the other way round
+    std::vector<std::uint64_t> faces; // bit s is set if s is a face
+    std::vector<std::uint32_t> links; // bit u of links[s] is set if s without u is a face
+    std::vector<Count128> chains;     // the chains down from s through faces
+    std::size_t nchanged;
+
+    bool face(nodemask s) const { return faces[s >> 6] >> (s & 63u) & 1u; }
+    /* Masks in the order the nodes came, from those of cg, and back */
+    nodemask inner(nodemask m) const;
+    nodemask outer(nodemask m) const;
+    /* Work out whether s is a face, then its links and chains, from those
+     * of the sets below it */
+    void update(nodemask s);
+    void flip(vsize_t u);
+
+    public:
+    /* Starting from the ringing of cg.
+     * Throws std::length_error if cg has more than FaceTable::maxnodes nodes. */
+    explicit RingingWalk(const CoxeterGraph& cg);
+
+    /* The diagram, ringed as the walk is now */
+    const CoxeterGraph& diagram() const { return cg; }
+
+    /* The ringed nodes */
+    nodemask ringing() const { return outer(ring); }
+
+    /* Is s a face under the current ringing? */
+    bool isface(nodemask s) const { return face(inner(s & all)); }
+
+    /* Ring node v if it isn't, or unring it if it is */
+    void toggle(vsize_t v) { flip(slot[v]); }
+
+    /* Change to the ringing r, one node at a time. Counting up in binary
+     * toggles two nodes per step on average. */
+    void moveto(nodemask r);
+
+    /* The number of sets which became or stopped being faces at the last
+     * toggle or insertnode */
+    std::size_t changed() const { return nchanged; }
+
+    /* Go on to the diagram grown, which must be this one with a node put in
+     * at index v, and the nodes from v on numbered one higher (as with
+     * newnode() for the families). The new node comes unringed, and the
+     * rest keep their ringing; the ringing of grown is ignored.
+     * Throws std::invalid_argument if grown isn't this diagram with one more
+     * node at v, or std::length_error if it is too big. */
+    void insertnode(const CoxeterGraph& grown, vsize_t v);
+
+    /* The poset of face orbits under the current ringing */
+    HasseDiagram freeze() const;
+
+    /* Its number of flag orbits */
+    Count128 flagorbits() const { return chains[all]; }
+};
+
+#endif // NAM_RINGINGWALK_H
@@ -0,0 +1,73 @@
+#include "symmetry.h"
+#include <algorithm> // min
+#include <stdexcept>
+
+using std::vector;
+using boost::num_vertices;
+
+constexpr std::size_t DiagramSymmetry::maxsize;
+
+DiagramSymmetry::DiagramSymmetry(const CoxeterGraph& cg) {
+    const vsize_t n = num_vertices(cg);
+    if (n > BitDiagram::maxnodes)
+        throw std::length_error("DiagramSymmetry: too many nodes for a bitmask");
+    all = n == BitDiagram::maxnodes ? ~nodemask{0} : nodebit(n) - 1;
+    // label[u*n + v] is 0 with no edge, and the order + 1 with one (0 is ∞)
+    vector<unsigned> label(n*n, 0);
+    vector<unsigned> degree(n, 0);
+    for (auto e : boost::make_iterator_range(edges(cg))) {
+        const vsize_t u = source(e, cg), v = target(e, cg);
+        label[u*n + v] = label[v*n + u] = cg[e].order + 1;
+        ++degree[u];
+        ++degree[v];
+    }
+
+    // image[v] for v < depth is chosen; try each unused node for v = depth
+    vector<vsize_t> image(n);
+    vector<vsize_t> next(n + 1, 0); // the next candidate image at each depth
+    nodemask used = 0;
+    vsize_t depth = 0;
+    while (perms.size() < maxsize) {
+        if (depth == n) {
+            perms.push_back(image);
+            if (n == 0)
+                break;
+            --depth;
+            used &= ~nodebit(image[depth]);
+            continue;
+        }
+        vsize_t& w = next[depth];
+        while (w < n) {
+            bool fits = !(used & nodebit(w)) && degree[w] == degree[depth];
+            for (vsize_t u = 0; fits && u < depth; ++u)
+                fits = label[u*n + depth] == label[image[u]*n + w];
+            if (fits)
+                break;
+            ++w;
+        }
+        if (w < n) {
+            image[depth] = w++;
+            used |= nodebit(image[depth]);
+            next[++depth] = 0;
+        } else if (depth == 0) {
+            break; // all tried
+        } else {
+            --depth;
+            used &= ~nodebit(image[depth]);
+        }
+    }
+}
+
+nodemask DiagramSymmetry::apply(std::size_t k, nodemask m) const {
+    nodemask img = 0;
+    for (m &= all; m; m &= m - 1)
+        img |= nodebit(perms[k][lownode(m)]);
+    return img;
+}
+
+nodemask DiagramSymmetry::canonical(nodemask m) const {
+    nodemask least = m & all;
+    for (std::size_t k = 1; k < perms.size(); ++k)
+        least = std::min(least, apply(k, m));
+    return least;
+}
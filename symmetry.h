@@ -0,0 +1,50 @@
+#ifndef NAM_SYMMETRY_H
+#define NAM_SYMMETRY_H
+
+#include <cstddef>
+#include <vector>
+#include "coxeter.h"
+#include "bitdiagram.h" // nodemask
+
+/*******************
+ * DiagramSymmetry *
+ *******************/
+
+/* The automorphisms of a Coxeter diagram: the permutations of its nodes
+ * which take every edge to an edge with the same order, and non-edges to
+ * non-edges. Which nodes are ringed is ignored. Ringings which one of
+ * these takes to another have the same poset of face orbits, with the
+ * nodes renamed, so only one of them need be worked out: the reversal
+ * of A_n, F_4 and I_2(p), the flip of E_6 and the legs of D_n, or all
+ * six permutations of the legs of D_4.
+ * They are found by backtracking, matching the nodes in order, and no
+ * more than maxsize are kept (which only matters for diagrams with many
+ * alike components); the identity is always first. */
+class DiagramSymmetry {
+    std::vector<std::vector<vsize_t>> perms; // perms[k][v] is where the k-th takes v
+    nodemask all; // the nodes of the diagram
+
+    public:
+    static constexpr std::size_t maxsize = 1024;
+
+    /* Throws std::length_error if cg has more than BitDiagram::maxnodes nodes */
+    explicit DiagramSymmetry(const CoxeterGraph& cg);
+
+    /* The number of automorphisms (at most maxsize) */
+    std::size_t size() const { return perms.size(); }
+
+    /* The k-th automorphism: node v goes to (*this)[k][v] */
+    const std::vector<vsize_t>& operator[](std::size_t k) const { return perms[k]; }
+
+    /* The image of the nodes in m under the k-th automorphism.
+     * Bits in m beyond the nodes of the diagram are dropped, as ringnodes
+     * drops them. */
+    nodemask apply(std::size_t k, nodemask m) const;
+
+    /* The least image of m under any automorphism; ringings with the same
+     * canonical ringing have the same number of flag orbits. It is never
+     * more than m. */
+    nodemask canonical(nodemask m) const;
+};
+
+#endif // NAM_SYMMETRY_H
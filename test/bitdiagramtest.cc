@@ -0,0 +1,76 @@
+#include "../bitdiagram.h"
+#include "../facetable.h"
+#include <cstdio>
+using std::printf;
+
+/* Compare BitDiagram::allringed (with each mask word) and FaceTable
+ * against allringed() on the induced subgraph, for every subset of nodes
+ * and every ringing of some small diagrams. */
+
+CoxeterGraph induced(CoxeterGraph cg, nodemask s) {
+    for (vsize_t v = num_vertices(cg); v-- > 0; ) {
+        if (!(s & nodebit(v))) {
+            boost::clear_vertex(v, cg);
+            boost::remove_vertex(v, cg);
+        }
+    }
+    return cg;
+}
+
+int checkall(const char* name, CoxeterGraph cg) {
+    const vsize_t n = num_vertices(cg);
+    int bad = 0;
+    const FaceTable table{cg};
+    for (unsigned b = 0; b < (1u << n); ++b) {
+        ringnodes(cg, b);
+        const BitDiagram bd{cg};
+        const BasicBitDiagram<std::uint32_t> narrow{cg};
+        const BasicBitDiagram<widemask> wide{cg};
+        for (nodemask s = 0; s < nodebit(n); ++s) {
+            const bool face = allringed(induced(cg, s));
+            if (bd.allringed(s) != face || table.isface(s, b) != face
+                    || narrow.allringed(s) != face || wide.allringed(s) != face) {
+                printf("Agh, %s ringed %x, subset %lx disagree!\n",
+                       name, b, static_cast<unsigned long>(s));
+                ++bad;
+            }
+            nodemask comps = 0;
+            for (auto c : table.components(s)) {
+                if (c & comps || bd.component(s, lownode(c)) != c) {
+                    printf("Agh, %s subset %lx has a bad component %lx!\n", name,
+                           static_cast<unsigned long>(s), static_cast<unsigned long>(c));
+                    ++bad;
+                }
+                comps |= c;
+            }
+            if (comps != s) {
+                printf("Agh, %s subset %lx components don't cover it!\n",
+                       name, static_cast<unsigned long>(s));
+                ++bad;
+            }
+        }
+    }
+    return bad;
+}
+
+int main() {
+    int bad = checkall("A5", linear_coxeter(5))
+            + checkall("B4", linear_coxeter(4, 4))
+            + checkall("D5", coxeterD(5))
+            + checkall("E6", coxeterE(6))
+            + checkall("F4", coxeterF4());
+
+    CoxeterGraph cycle = linear_coxeter(5); // affine A_4, to have a cycle
+    boost::add_edge(4u, 0u, {3u}, cycle);
+    bad += checkall("~A4", cycle);
+    bad += checkall("E8", coxeterE(8));
+
+    const BitDiagram bd{linear_coxeter(64)};
+    if (bd.all() != ~nodemask{0})
+        printf("Agh, all() is wrong for 64 nodes!\n");
+    const BasicBitDiagram<widemask> wide{linear_coxeter(128)};
+    if (wide.all() != ~widemask{0} || wide.component(wide.all(), 127) != wide.all()
+            || MaskBits<widemask>::low(wide.neighbours(127)) != 126)
+        printf("Agh, 128 nodes are wrong!\n");
+    return bad != 0;
+}
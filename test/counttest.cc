@@ -0,0 +1,324 @@
+#include "flagcount.h"
+#include "../grouporder.h"
+#include "../intervalcache.h"
+#include "../pathcount.h"
+#include "../poset.h"
+#include "../symmetry.h"
+#include <cstdio>
+#include <stdexcept>
+using std::printf;
+
+IntervalCache memo; // shared by all the checks, as it is in truncations
+
+/* Check countflags and the cache against the full poset for every ringing
+ * of cg, and the cache against every face of the poset; and if cg is a
+ * path, PathCount against the poset's flags and its faces of each rank */
+void allringings(const char* name, CoxeterGraph cg) {
+    const unsigned n = num_vertices(cg);
+    const FaceTable table{cg};
+    const std::vector<vsize_t> order = pathorder(cg);
+    for (unsigned b = 0; b < (1u << n); ++b) {
+        ringnodes(cg, b);
+        FaceOrbitPoset hasse{cg};
+        Count128 slow = hasse.head->numpaths();
+        Count128 fast = countflags(cg), cached = memo.flagorbits(cg);
+        if (fast != slow || cached != slow)
+            printf("Agh, %s ringing %u: %s, %s != %s!\n", name, b,
+                   fast.str().c_str(), cached.str().c_str(), slow.str().c_str());
+        if (IntervalCache{}.flagorbits(cg, table) != slow)
+            printf("Agh, %s ringing %u with a FaceTable is wrong!\n", name, b);
+        if (!order.empty()) {
+            PathCount path{pathringing(cg, order)};
+            if (path.flagorbits() != slow)
+                printf("Agh, %s ringing %u on the path: %s != %s!\n", name, b,
+                       path.flagorbits().str().c_str(), slow.str().c_str());
+            const std::vector<Count128> faces = path.faces();
+            for (unsigned r = 0; b != 0 && r <= n; ++r) {
+                if (faces[r] != Count128(hasse.nodes[r].size()))
+                    printf("Agh, %s ringing %u has %s faces of rank %u, not %zu!\n", name, b,
+                           faces[r].str().c_str(), r, hasse.nodes[r].size());
+            }
+        }
+        for (const auto& layer : hasse.nodes) {
+            for (const auto& nd : layer) {
+                if (&nd != hasse.head && memo.chains(cg, nd.mask) != nd.numpaths())
+                    printf("Agh, %s ringing %u face %llx: %s != %s!\n", name, b,
+                           (unsigned long long)nd.mask,
+                           memo.chains(cg, nd.mask).str().c_str(),
+                           nd.numpaths().str().c_str());
+            }
+        }
+    }
+}
+
+/* Check that cg has the expected number of automorphisms, each keeping
+ * every edge order, and that each ringing has as many flag orbits as its
+ * canonical ringing */
+void automorphic(const char* name, CoxeterGraph cg, std::size_t expected) {
+    const unsigned n = num_vertices(cg);
+    const DiagramSymmetry sym{cg};
+    if (sym.size() != expected)
+        printf("Agh, %s has %zu automorphisms, not %zu!\n", name, sym.size(), expected);
+    for (std::size_t k = 0; k < sym.size(); ++k) {
+        for (auto e : boost::make_iterator_range(edges(cg))) {
+            const auto img = boost::edge(sym[k][source(e, cg)], sym[k][target(e, cg)], cg);
+            if (!img.second || cg[img.first].order != cg[e].order)
+                printf("Agh, %s automorphism %zu breaks an edge!\n", name, k);
+        }
+    }
+    for (unsigned b = 0; b < (1u << n); ++b) {
+        CoxeterGraph canon = cg;
+        ringnodes(cg, b);
+        ringnodes(canon, sym.canonical(b));
+        if (sym.canonical(b) > b || memo.flagorbits(cg) != memo.flagorbits(canon))
+            printf("Agh, %s ringing %u differs from its canonical ringing!\n", name, b);
+    }
+}
+
+/* Is cg's group of the order given, or infinite if that is 0? */
+bool ordered(const CoxeterGraph& cg, Count128 expected) {
+    try {
+        return GroupOrder{cg}.order() == expected;
+    } catch (const std::domain_error&) {
+        return expected == 0;
+    }
+}
+
+/* The faces of each rank and the flags of cg's polytope, as
+ * "f_0 f_1 ...; flags" */
+std::string polytope(const CoxeterGraph& cg) {
+    const HasseDiagram hd = FaceOrbitPoset{cg}.freeze();
+    const std::vector<Count128> sizes = orbitsizes(hd);
+    std::vector<Count128> faces(hd.rank(hd.head()));
+    for (HasseDiagram::nodeid i = 0; i < hd.head(); ++i)
+        faces[hd.rank(i)] += sizes[i];
+    Count128 flags;
+    for (auto f : flagsizes(hd))
+        flags += f;
+    std::string list;
+    for (auto f : faces)
+        list += f.str() + ' ';
+    return list + "; " + flags.str();
+}
+
+/* Does every ringing of cg give a polytope whose face counts have the
+ * alternating sum Euler's relation requires? */
+bool euler(CoxeterGraph cg) {
+    const unsigned n = num_vertices(cg);
+    for (unsigned b = 1; b < (1u << n); ++b) {
+        ringnodes(cg, b);
+        const HasseDiagram hd = FaceOrbitPoset{cg}.freeze();
+        const std::vector<Count128> sizes = orbitsizes(hd);
+        Count128 even = 0, odd = 0;
+        for (HasseDiagram::nodeid i = 0; i < hd.head(); ++i)
+            (hd.rank(i) % 2 ? odd : even) += sizes[i];
+        if (even != odd + (n % 2 ? 2 : 0))
+            return false;
+    }
+    return true;
+}
+
+int main() {
+    allringings("A1", linear_coxeter(1));
+    allringings("I2(5)", linear_coxeter(2, 5));
+    allringings("A6", linear_coxeter(6));
+    allringings("B5", linear_coxeter(5, 4));
+    allringings("H4", linear_coxeter(4, 5));
+    allringings("D6", coxeterD(6));
+    allringings("E6", coxeterE(6));
+    allringings("F4", coxeterF4());
+
+    /* A disconnected diagram, A2 + A3 */
+    CoxeterGraph cg = linear_coxeter(5);
+    boost::remove_edge(1u, 2u, cg);
+    allringings("A2+A3", cg);
+    automorphic("A2+A3", cg, 4);
+
+    /* A cycle: the affine diagram of A4 */
+    cg = linear_coxeter(5);
+    boost::add_edge(4u, 0u, {3u}, cg);
+    allringings("~A4", cg);
+    automorphic("~A4", cg, 10); // rotations and reflections of the pentagon
+
+    automorphic("A6", linear_coxeter(6), 2);
+    automorphic("B5", linear_coxeter(5, 4), 1);
+    automorphic("I2(5)", linear_coxeter(2, 5), 2);
+    automorphic("D4", coxeterD(4), 6);
+    automorphic("D6", coxeterD(6), 2);
+    automorphic("E6", coxeterE(6), 2);
+    automorphic("E7", coxeterE(7), 1);
+    automorphic("F4", coxeterF4(), 2);
+
+    /* The omnitruncated A20 has 20! flag orbits */
+    cg = linear_coxeter(20);
+    ringnodes(cg, (1u << 20) - 1);
+    if (countflags(cg).str() != "2432902008176640000")
+        printf("Agh, A20 gave %s!\n", countflags(cg).str().c_str());
+
+    /* Every A_k piece of the omnitruncated A30 is one class, so only
+     * 30 of them are needed; and 30! doesn't fit in 64 bits */
+    IntervalCache fresh;
+    cg = linear_coxeter(30);
+    ringnodes(cg, (1u << 30) - 1);
+    if (fresh.flagorbits(cg).str() != "265252859812191058636308480000000")
+        printf("Agh, A30 gave %s!\n", fresh.flagorbits(cg).str().c_str());
+    if (fresh.size() != 30)
+        printf("Agh, A30 has %zu classes!\n", fresh.size());
+
+    /* The same shape in a different place, or with the nodes numbered
+     * backwards, is found in the cache */
+    CoxeterGraph b5 = linear_coxeter(5, 4), rev(5);
+    for (unsigned i = 0; i + 1 < 5; ++i)
+        boost::add_edge(4 - i, 3 - i, {i == 0 ? 4u : 3u}, rev);
+    ringnodes(b5, "10010");
+    ringnodes(rev, "01001");
+    const std::size_t before = fresh.size();
+    fresh.flagorbits(b5);
+    const std::size_t after = fresh.size();
+    fresh.flagorbits(rev);
+    if (fresh.size() != after || after == before)
+        printf("Agh, reversed B5 wasn't found in the cache!\n");
+
+    /* t_{0,2}(A_n) has (n - 1)^2 flag orbits, whichever mask word the
+     * cache uses (32 bits, 64, or 128), and all of them share the memo */
+    for (unsigned n : {31u, 32u, 33u, 64u, 65u, 100u, 128u}) {
+        cg = linear_coxeter(n);
+        ringnodes(cg, "101");
+        if (fresh.flagorbits(cg) != Count128((n - 1)*(n - 1)))
+            printf("Agh, t_{0,2}(A%u) gave %s!\n", n, fresh.flagorbits(cg).str().c_str());
+    }
+    /* t_{0,n-1}(A_n) has 2^(n - 1) flag orbits, and t_{0,67}(D68) a little
+     * over 2^72; from about 68 nodes on, the binomials which interleave the
+     * faces' components don't fit in 64 bits */
+    Count128 power = 1;
+    for (unsigned n = 2; n <= IntervalCache::maxnodes; ++n) {
+        power *= 2;
+        cg = linear_coxeter(n);
+        ringnodes(cg, "1" + std::string(n - 2, '0') + "1");
+        if (fresh.flagorbits(cg) != power)
+            printf("Agh, t_{0,%u}(A%u) gave %s!\n", n - 1, n, fresh.flagorbits(cg).str().c_str());
+    }
+    cg = coxeterD(68);
+    ringnodes(cg, "1" + std::string(66, '0') + "1");
+    if (fresh.flagorbits(cg).str() != "4722366482869645213766")
+        printf("Agh, t_{0,67}(D68) gave %s!\n", fresh.flagorbits(cg).str().c_str());
+
+    bool threw = false;
+    try {
+        fresh.flagorbits(linear_coxeter(IntervalCache::maxnodes + 1));
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    if (!threw)
+        printf("Agh, %u nodes weren't refused!\n", unsigned(IntervalCache::maxnodes + 1));
+
+    /* Only paths have a path order; it starts at the lower end */
+    cg = linear_coxeter(5);
+    boost::remove_edge(1u, 2u, cg);
+    if (!pathorder(coxeterD(6)).empty() || !pathorder(coxeterE(6)).empty()
+            || !pathorder(cg).empty())
+        printf("Agh, a diagram which isn't a path has a path order!\n");
+    if (pathorder(rev) != std::vector<vsize_t>{0, 1, 2, 3, 4})
+        printf("Agh, reversed B5 is out of order!\n");
+    cg = CoxeterGraph(4);
+    boost::add_edge(2u, 0u, {3u}, cg);
+    boost::add_edge(0u, 3u, {3u}, cg);
+    boost::add_edge(3u, 1u, {5u}, cg);
+    if (pathorder(cg) != std::vector<vsize_t>{1, 3, 0, 2})
+        printf("Agh, a shuffled H4 is out of order!\n");
+
+    /* Every stretch of one path counts the same as a diagram of its own */
+    const char* pattern = "0100100011010000101";
+    std::vector<bool> line;
+    for (const char* c = pattern; *c; ++c)
+        line.push_back(*c == '1');
+    PathCount path{line};
+    for (unsigned i = 0; i <= line.size(); ++i) {
+        for (unsigned j = i; j <= line.size(); ++j) {
+            cg = linear_coxeter(j - i);
+            ringnodes(cg, std::string(pattern + i, j - i));
+            if (path.flagorbits(i, j) != memo.flagorbits(cg))
+                printf("Agh, nodes %u to %u of the path gave %s!\n", i, j,
+                       path.flagorbits(i, j).str().c_str());
+        }
+    }
+
+    /* and a path which grows keeps its counts; far past what a mask
+     * holds, t_{0,2}(A_n) still has (n - 1)^2 flag orbits */
+    path.assign({true, false, true});
+    for (unsigned n = 3; n <= 400; ++n) {
+        line.assign(n, false);
+        line[0] = line[2] = true;
+        path.assign(line);
+        if (path.flagorbits() != Count128((n - 1)*(n - 1)))
+            printf("Agh, t_{0,2}(A%u) on the path gave %s!\n", n, path.flagorbits().str().c_str());
+    }
+
+    /* 34! fits in 128 bits and 35! doesn't */
+    path.assign(std::vector<bool>(35, true));
+    if (path.flagorbits(0, 34).str() != "295232799039604140847618609643520000000")
+        printf("Agh, the omnitruncated A34 gave %s!\n", path.flagorbits(0, 34).str().c_str());
+    threw = false;
+    try {
+        path.flagorbits();
+    } catch (const std::overflow_error&) {
+        threw = true;
+    }
+    if (!threw)
+        printf("Agh, 35! fit in 128 bits!\n");
+
+
+    /* The group orders of the finite types, and products of them */
+    CoxeterGraph split = linear_coxeter(5), cycle = linear_coxeter(5);
+    boost::remove_edge(1u, 2u, split);
+    boost::add_edge(4u, 0u, {3u}, cycle);
+    const struct { const char* name; CoxeterGraph cg; Count128 order; } groups[] = {
+        {"A1", linear_coxeter(1), 2},
+        {"A5", linear_coxeter(5), 720},
+        {"B4", linear_coxeter(4, 4), 384},
+        {"D4", coxeterD(4), 192},
+        {"D6", coxeterD(6), 23040},
+        {"E6", coxeterE(6), 51840},
+        {"E7", coxeterE(7), 2903040},
+        {"E8", coxeterE(8), 696729600},
+        {"F4", coxeterF4(), 1152},
+        {"H3", linear_coxeter(3, 5), 120},
+        {"H4", linear_coxeter(4, 5), 14400},
+        {"I2(7)", linear_coxeter(2, 7), 14},
+        {"A2+A3", split, 144},
+        {"B5 backwards", rev, 3840},
+        {"~A4", cycle, 0},
+        {"E9", coxeterE(9), 0},
+        {"H5", linear_coxeter(5, 5), 0},
+        {"G3", linear_coxeter(3, 6), 0},
+        {"I2(∞)", linear_coxeter(2, 0), 0},
+    };
+    for (const auto& g : groups) {
+        if (!ordered(g.cg, g.order))
+            printf("Agh, the group of %s has the wrong order!\n", g.name);
+    }
+    /* E8 without its first node is D7 */
+    if (GroupOrder{coxeterE(8)}.order(0xfe) != Count128(322560))
+        printf("Agh, D7 in E8 has the wrong order!\n");
+
+    /* The polytopes themselves: the cube, the cuboctahedron, the truncated
+     * octahedron, and the 120-cell */
+    const struct { CoxeterGraph cg; const char* ringing; const char* counts; } polytopes[] = {
+        {linear_coxeter(3, 4), "100", "8 12 6 ; 48"},
+        {linear_coxeter(3, 4), "010", "12 24 14 ; 96"},
+        {linear_coxeter(3), "111", "24 36 14 ; 144"},
+        {linear_coxeter(4, 5), "1000", "600 1200 720 120 ; 14400"},
+    };
+    for (auto p : polytopes) {
+        ringnodes(p.cg, p.ringing);
+        if (polytope(p.cg) != p.counts)
+            printf("Agh, t_%s gave %s, not %s!\n", p.ringing, polytope(p.cg).c_str(), p.counts);
+    }
+    for (const auto& g : {linear_coxeter(4), linear_coxeter(4, 4), coxeterD(4),
+                          coxeterF4(), linear_coxeter(4, 5), linear_coxeter(5)}) {
+        if (!euler(g))
+            printf("Agh, a polytope of %u nodes breaks Euler's relation!\n",
+                   unsigned(num_vertices(g)));
+    }
+    return 0;
+}
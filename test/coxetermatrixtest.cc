@@ -0,0 +1,60 @@
+#include "../bitdiagram.h"
+#include "../coxetermatrix.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+using std::printf;
+
+/* The catalogue is worked out at compile time */
+constexpr auto e8 = coxetermatrix<8>('E', 8);
+static_assert(e8.size() == 8 && e8.neighbours(2) == 0x8a
+              && e8.order(1, 2) == 3 && e8.order(0, 7) == 2 && e8.order(5, 5) == 1,
+              "E8 should be a path of 7 with a leg at node 2");
+static_assert(coxetermatrix<4>('F', 4).order(1, 2) == 4 && coxetermatrix<2>('I', 7).order(0, 1) == 7,
+              "F4 and I2(7) should have their labelled edges");
+static_assert(coxeterplaces<5>('D', 5).y[4] == 1 && coxeterplaces<5>('D', 5).x[3] == 3,
+              "D5 should fork at the end");
+
+/* Check the catalogue of CoxeterMatrix against coxeter_dispatch, and the
+ * conversions to and from CoxeterGraph */
+int checkcatalogue() {
+    int bad = 0;
+    for (char c : std::string("ABCDEFGHI")) {
+        for (unsigned n = c == 'I' ? 3 : 0; n <= 16; ++n) {
+            CoxeterGraph cg = coxeter_dispatch(c, n);
+            ringnodes(cg, 0x5u);
+            CoxeterMatrix<16> m = coxetermatrix<16>(c, n);
+            m.setringed(0x5u);
+            const DiagramPlaces<16> at = coxeterplaces<16>(c, n);
+            const BitDiagram bd{tograph(m)};
+            bool same = tomatrix<16>(cg) == m && places<16>(cg) == at
+                     && tomatrix<16>(tograph(m, at)) == m && places<16>(tograph(m, at)) == at
+                     && bd.ringed() == m.ringed();
+            for (vsize_t v = 0; v < m.size(); ++v)
+                same = same && bd.neighbours(v) == m.neighbours(v);
+            if (!same) {
+                printf("Agh, the catalogue's %c%u differs!\n", c, n);
+                ++bad;
+            }
+        }
+    }
+    // joins which don't make an edge between two nodes are refused
+    const struct { vsize_t u, v; unsigned p; } wrong[] = {
+        {2, 2, 3}, {0, 4, 3}, {4, 0, 3}, {0, 1, 256}
+    };
+    for (auto w : wrong) {
+        CoxeterMatrix<16> m(4);
+        try {
+            m.join(w.u, w.v, w.p);
+            printf("Agh, joining %u and %u by %u wasn't refused!\n",
+                   unsigned(w.u), unsigned(w.v), w.p);
+            ++bad;
+        } catch (const std::logic_error&) {
+        }
+    }
+    return bad;
+}
+
+int main() {
+    return checkcatalogue() != 0;
+}
@@ -0,0 +1,55 @@
+#include "flagcount.h"
+#include "../maskindex.h"
+#include <vector>
+
+using std::vector;
+
+Count128 countflags(const CoxeterGraph& cg) {
+    return countflags(BitDiagram{cg});
+}
+
+Count128 countflags(const BitDiagram& bd) {
+    const vsize_t n = bd.size();
+    if (n == 0)
+        return 1;
+    // The faces of one rank: their masks, the nodes which could be added to
+    // each to make a bigger face (ringed nodes, and neighbours of the face),
+    // and the number of chains down from each.
+    vector<nodemask> masks{0}, grows{bd.ringed()};
+    vector<Count128> counts{1};
+    vector<nodemask> upmasks, upgrows;
+    vector<Count128> upcounts;
+    MaskIndex index;
+    for (vsize_t r = 0; r + 1 < n; ++r) {
+        index.clear();
+        upmasks.clear();
+        upgrows.clear();
+        upcounts.clear();
+        for (std::size_t i = 0; i < masks.size(); ++i) {
+            // s + v is a face exactly when v is ringed or next to s
+            for (nodemask rest = grows[i] & ~masks[i]; rest; rest &= rest - 1) {
+                const vsize_t v = lownode(rest);
+                auto up = index.insert(masks[i] | nodebit(v));
+                if (up.second) {
+                    upmasks.push_back(masks[i] | nodebit(v));
+                    upgrows.push_back(grows[i] | bd.neighbours(v));
+                    upcounts.push_back(counts[i]);
+                } else {
+                    upcounts[up.first] += counts[i];
+                }
+            }
+        }
+        masks.swap(upmasks);
+        grows.swap(upgrows);
+        counts.swap(upcounts);
+    }
+    // Every face of rank n - 1 is a child of the whole diagram. The whole
+    // diagram needn't be a face itself (if some component is unringed),
+    // but it's always the head of the poset.
+    if (masks.empty())
+        return 1;
+    Count128 total = 0;
+    for (auto c : counts)
+        total += c;
+    return total;
+}
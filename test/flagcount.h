@@ -0,0 +1,27 @@
+#ifndef NAM_FLAGCOUNT_H
+#define NAM_FLAGCOUNT_H
+
+#include "../coxeter.h"
+#include "../bitdiagram.h"
+#include "../count128.h"
+
+/* Counting flag orbits without building a FaceOrbitPoset, in the plainest
+ * way. This was the first such count; IntervalCache, which shares the work
+ * between faces and between diagrams, replaced it in the programs, and it
+ * stays here as the reference counttest checks the faster counts against.
+ *
+ * The faces are exactly the subsets of nodes with a ringed node in every
+ * connected component, and the flag orbits are the saturated chains from
+ * the whole diagram down to the empty set. So the count is a dynamic
+ * program over subsets: the number of chains below a face is the sum
+ * over its faces one rank down.
+ * It runs upward a rank at a time, so only two ranks of masks and counts
+ * are held at once, with no PosetNodes, graphs, or links at all.
+ * The answer is always FaceOrbitPoset{cg}.head->numpaths(). */
+
+/* Throws std::length_error if cg has more than BitDiagram::maxnodes nodes */
+Count128 countflags(const CoxeterGraph& cg);
+
+Count128 countflags(const BitDiagram& bd);
+
+#endif // NAM_FLAGCOUNT_H
@@ -0,0 +1,534 @@
+#include "../poset.h"
+#include "../flagvector.h"
+#include "../orbitgraph.h"
+#include "../orbitcache.h"
+#include "../ringingwalk.h"
+#include <algorithm> // none_of, sort
+#include <array>
+#include <cstdio>
+#include <cstdlib> // malloc, free
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string>
+using std::printf;
+using std::string;
+
+/* Count every allocation from the heap */
+std::size_t heapallocs = 0;
+
+void* operator new(std::size_t n) {
+    ++heapallocs;
+    if (void* p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#define CHECK_EQ(ans, val) if ((ans) != (val)) \
+    printf("Agh, %s != %s on line %d!\n", Count128(ans).str().c_str(), \
+           Count128(val).str().c_str(), __LINE__);
+
+Count128 flagorbits(CoxeterGraph cg, const string& ringing) {
+    ringnodes(cg, ringing);
+    return FaceOrbitPoset{cg}.head->numpaths();
+}
+
+/* Do two posets have the same nodes in the same order, with the same links
+ * in the same order? */
+bool samestructure(const FaceOrbitPoset& a, const FaceOrbitPoset& b) {
+    if (a.nodes.size() != b.nodes.size())
+        return false;
+    auto masks = [](const LinkSpan& v) {
+        std::vector<nodemask> m;
+        for (auto p : v)
+            m.push_back(p->mask);
+        return m;
+    };
+    for (size_t r = 0; r < a.nodes.size(); ++r) {
+        if (a.nodes[r].size() != b.nodes[r].size())
+            return false;
+        for (size_t i = 0; i < a.nodes[r].size(); ++i) {
+            const PosetNode& x = a.nodes[r][i];
+            const PosetNode& y = b.nodes[r][i];
+            if (x.mask != y.mask || x.paths != y.paths
+                    || masks(x.parents) != masks(y.parents)
+                    || masks(x.children) != masks(y.children))
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Does the frozen diagram have the same nodes and links as the poset? */
+bool samefrozen(const FaceOrbitPoset& fop, const HasseDiagram& hd) {
+    auto masks = [&hd](HasseDiagram::idrange ids) {
+        std::vector<nodemask> m;
+        for (auto i : ids)
+            m.push_back(hd.mask(i));
+        return m;
+    };
+    auto nodemasks = [](const LinkSpan& v) {
+        std::vector<nodemask> m;
+        for (auto p : v)
+            m.push_back(p->mask);
+        return m;
+    };
+    const auto paths = hd.numpaths();
+    if (hd.numranks() != fop.nodes.size() || hd.mask(hd.head()) != fop.head->mask)
+        return false;
+    for (unsigned r = 0; r < hd.numranks(); ++r) {
+        if (hd.rankend(r) - hd.rankbegin(r) != fop.nodes[r].size())
+            return false;
+        for (auto i = hd.rankbegin(r); i < hd.rankend(r); ++i) {
+            const PosetNode& pn = fop.nodes[r][i - hd.rankbegin(r)];
+            if (hd.mask(i) != pn.mask || hd.rank(i) != r || paths[i] != pn.paths
+                    || masks(hd.parents(i)) != nodemasks(pn.parents)
+                    || masks(hd.children(i)) != nodemasks(pn.children))
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Chains listed the simple recursive way, bottom to top */
+void allchains(const HasseDiagram& hd, HasseDiagram::nodeid i,
+               std::vector<HasseDiagram::nodeid>& down,
+               std::vector<std::vector<HasseDiagram::nodeid>>& out) {
+    down.push_back(i);
+    if (hd.children(i).empty())
+        out.emplace_back(down.rbegin(), down.rend());
+    for (auto kid : hd.children(i))
+        allchains(hd, kid, down, out);
+    down.pop_back();
+}
+
+/* Chains of faces below the head, each face's mask inside the next, counted
+ * by their ranks the simple recursive way, starting from face i */
+void risingchains(const HasseDiagram& hd, HasseDiagram::nodeid i, unsigned set,
+                  std::vector<Count128>& count) {
+    set |= 1u << hd.rank(i);
+    count[set] += 1;
+    for (HasseDiagram::nodeid j = hd.rankend(hd.rank(i)); j < hd.head(); ++j) {
+        if ((hd.mask(i) & ~hd.mask(j)) == 0)
+            risingchains(hd, j, set, count);
+    }
+}
+
+/* Do fvector and flagvector count the faces and the chains of each rank
+ * set that risingchains finds? */
+bool flagcounts(const HasseDiagram& hd) {
+    const unsigned n = hd.rank(hd.head());
+    std::vector<Count128> count(1u << n);
+    count[0] = 1;
+    for (HasseDiagram::nodeid i = 0; i < hd.head(); ++i)
+        risingchains(hd, i, 0, count);
+    const std::vector<std::size_t> f = fvector(hd);
+    for (unsigned r = 0; r < n; ++r) {
+        if (count[1u << r] != Count128(f[r]))
+            return false;
+    }
+    return f.size() == n && flagvector(hd) == count;
+}
+
+/* Does ChainEnumerator give the chains in order, and resume anywhere?
+ * Does ChainRanking number them the same way? */
+bool streams(const HasseDiagram& hd) {
+    std::vector<HasseDiagram::nodeid> down;
+    std::vector<std::vector<HasseDiagram::nodeid>> chains;
+    allchains(hd, hd.head(), down, chains);
+    ChainEnumerator e{hd};
+    if (e.size() != chains.size())
+        return false;
+    for (std::size_t i = 0; i < chains.size(); ++i, e.next()) {
+        if (e.done() || e.current() != chains[i] || e.position() != i)
+            return false;
+    }
+    if (!e.done())
+        return false;
+    const ChainRanking ranking{hd};
+    std::vector<HasseDiagram::nodeid> buffer;
+    for (std::size_t i = 0; i < chains.size(); ++i) {
+        ranking.unrank(i, buffer);
+        if (ranking.rank(chains[i]) != i || buffer != chains[i])
+            return false;
+    }
+    for (std::size_t i = 0; i <= chains.size(); i += 7) {
+        ChainEnumerator s{hd};
+        s.seek(i);
+        if (i < chains.size() ? s.done() || s.current() != chains[i] : !s.done())
+            return false;
+        if (i + 1 < chains.size()) {
+            s.next();
+            if (s.current() != chains[i + 1])
+                return false;
+        }
+    }
+    return true;
+}
+
+/* The edges of the orbit graph, (source, target, label) in order */
+template <typename Graph>
+std::vector<std::array<int, 3>> edgelist(const Graph& og) {
+    using boost::edges;
+    using boost::source;
+    using boost::target;
+    std::vector<std::array<int, 3>> list;
+    auto edgits = edges(og);
+    for (auto eit = edgits.first; eit != edgits.second; ++eit)
+        list.push_back({static_cast<int>(source(*eit, og)),
+                        static_cast<int>(target(*eit, og)), og[*eit].rank});
+    return list;
+}
+
+/* Does every edge at each vertex of the compact graph appear at its other
+ * end too, with the same label, and add up to twice the edges? */
+bool symmetric(const CompactOrbitGraph& og) {
+    std::size_t total = 0;
+    for (auto v : boost::make_iterator_range(vertices(og))) {
+        total += out_degree(v, og);
+        for (auto e : boost::make_iterator_range(out_edges(v, og))) {
+            const auto u = target(e, og);
+            auto back = out_edges(u, og);
+            if (source(e, og) != v || std::none_of(back.first, back.second,
+                    [&](const CompactOrbitGraph::edge& f) {
+                        return target(f, og) == v && og[f].rank == og[e].rank;
+                    }))
+                return false;
+        }
+    }
+    return total == 2*num_edges(og);
+}
+
+/* Does makeOrbit match comparing every pair of flags, with any number of
+ * threads? */
+bool sameorbit(const HasseDiagram& hd) {
+    std::vector<HasseDiagram::nodeid> down;
+    std::vector<std::vector<HasseDiagram::nodeid>> chains;
+    allchains(hd, hd.head(), down, chains);
+    std::vector<std::array<int, 3>> pairwise;
+    for (std::size_t i = 0; i < chains.size(); ++i) {
+        for (std::size_t j = i + 1; j < chains.size(); ++j) {
+            int differ = 0, at = -1;
+            for (std::size_t d = 0; d < chains[i].size(); ++d) {
+                if (chains[i][d] != chains[j][d]) {
+                    ++differ;
+                    at = d;
+                }
+            }
+            if (differ == 1)
+                pairwise.push_back({static_cast<int>(i), static_cast<int>(j), at});
+        }
+    }
+    const auto compact = makeCompactOrbit(hd, 2);
+    return edgelist(makeOrbit(hd)) == pairwise && edgelist(makeOrbit(hd, 3)) == pairwise
+        && edgelist(compact) == pairwise && symmetric(compact)
+        && num_vertices(compact) == chains.size();
+}
+
+/* Do the barycenter passes keep each rank's nodes and never add
+ * crossings, and does crossings() count what checking every pair of links
+ * counts? */
+bool untangles(const HasseDiagram& hd) {
+    typedef HasseDiagram::nodeid nodeid;
+    auto paircount = [&hd](const std::vector<std::vector<nodeid>>& order) {
+        std::vector<std::size_t> pos(hd.size());
+        for (const auto& rank : order) {
+            for (std::size_t k = 0; k < rank.size(); ++k)
+                pos[rank[k]] = k;
+        }
+        std::uint64_t count = 0;
+        for (nodeid a = 0; a < hd.size(); ++a) {
+            for (nodeid b = 0; b < hd.size(); ++b) {
+                if (hd.rank(a) != hd.rank(b) || pos[a] >= pos[b])
+                    continue;
+                for (auto pa : hd.parents(a)) {
+                    for (auto pb : hd.parents(b))
+                        count += pos[pa] > pos[pb];
+                }
+            }
+        }
+        return count;
+    };
+    const auto plain = hd.rankorder(), swept = hd.rankorder(6);
+    for (unsigned y = 0; y < hd.numranks(); ++y) {
+        auto sorted = swept[y];
+        std::sort(sorted.begin(), sorted.end());
+        for (std::size_t k = 0; k < sorted.size(); ++k) {
+            if (sorted[k] != hd.rankbegin(y) + k)
+                return false;
+        }
+    }
+    return hd.crossings(plain) == paircount(plain) && hd.crossings(swept) == paircount(swept)
+        && hd.crossings(swept) <= hd.crossings(plain);
+}
+
+/* Does moving a walk to each ringing of cg in turn give the same posets and
+ * counts as building each afresh? And does toggling each node from there
+ * change just the faces that change, and keep the poset and counts right? */
+bool samewalk(const CoxeterGraph& cg) {
+    const FaceTable table{cg};
+    RingingWalk walk{cg};
+    bool same = true;
+    CoxeterGraph ringed = cg;
+    for (nodemask b = 0; b < (nodemask{1} << num_vertices(cg)); ++b) {
+        walk.moveto(b);
+        ringnodes(ringed, b);
+        if (!samefrozen(FaceOrbitPoset{ringed}, walk.freeze())
+                || walk.flagorbits() != FaceOrbitPoset{ringed}.head->numpaths())
+            same = false;
+        for (vsize_t v = 0; v < num_vertices(cg); ++v) {
+            std::size_t changed = 0;
+            for (nodemask s = 0; s < (nodemask{1} << num_vertices(cg)); ++s) {
+                if (table.isface(s, b) != table.isface(s, b ^ nodebit(v)))
+                    ++changed;
+            }
+            walk.toggle(v);
+            CoxeterGraph flipped = cg;
+            ringnodes(flipped, b ^ nodebit(v));
+            if (walk.changed() != changed || walk.ringing() != (b ^ nodebit(v))
+                    || !samefrozen(FaceOrbitPoset{flipped}, walk.freeze())
+                    || walk.flagorbits() != FaceOrbitPoset{flipped}.head->numpaths())
+                same = false;
+            walk.toggle(v);
+        }
+    }
+    return same;
+}
+
+/* Does growing a walk through the family c, ringed by pattern, from the
+ * length of pattern up to maxn nodes, give the same posets as building each
+ * afresh? */
+bool samegrowth(char c, const string& pattern, vsize_t maxn) {
+    CoxeterGraph cg = coxeter_dispatch(c, pattern.size());
+    ringnodes(cg, pattern);
+    RingingWalk walk{cg};
+    bool same = samefrozen(FaceOrbitPoset{cg}, walk.freeze());
+    for (vsize_t n = pattern.size() + 1; n <= maxn; ++n) {
+        cg = coxeter_dispatch(c, n);
+        ringnodes(cg, pattern);
+        walk.insertnode(cg, newnode(c, n - 1));
+        walk.moveto(BitDiagram{cg}.ringed());
+        if (!samefrozen(FaceOrbitPoset{cg}, walk.freeze())
+                || walk.flagorbits() != FaceOrbitPoset{cg}.head->numpaths())
+            same = false;
+    }
+    return same;
+}
+
+int main() {
+    /* Omnitruncated A_n has n! flag orbits */
+    uint64_t fact = 1;
+    for (unsigned n = 1; n <= 10; ++n) {
+        fact *= n;
+        CHECK_EQ(flagorbits(linear_coxeter(n), string(n, '1')), fact);
+    }
+
+    CHECK_EQ(flagorbits(linear_coxeter(4), "1001"), 8);
+    CHECK_EQ(flagorbits(linear_coxeter(4, 5), "1001"), 8);
+    CHECK_EQ(flagorbits(linear_coxeter(5), "10100"), 16);
+    CHECK_EQ(flagorbits(coxeterD(5), "01011"), 48);
+    CHECK_EQ(flagorbits(coxeterE(7), "0111111"), 2520);
+    CHECK_EQ(flagorbits(coxeterF4(), "0110"), 6);
+    CHECK_EQ(flagorbits(linear_coxeter(3), "000"), 1);
+
+    /* Parallel construction gives exactly the same poset */
+    CoxeterGraph cg = linear_coxeter(12);
+    ringnodes(cg, string(12, '1'));
+    if (!samestructure(FaceOrbitPoset{cg}, FaceOrbitPoset{cg, 4}))
+        printf("Agh, parallel A12 differs!\n");
+    cg = coxeterD(11);
+    ringnodes(cg, "10010010011");
+    if (!samestructure(FaceOrbitPoset{cg}, FaceOrbitPoset{cg, 3}))
+        printf("Agh, parallel D11 differs!\n");
+
+    /* Freezing keeps everything, with the ranks in order */
+    cg = coxeterE(7);
+    ringnodes(cg, "1010011");
+    FaceOrbitPoset e7{cg};
+    if (!samefrozen(e7, e7.freeze()))
+        printf("Agh, frozen E7 differs!\n");
+    const HasseDiagram e7frozen = e7.freeze();
+    if (!streams(e7frozen))
+        printf("Agh, E7 chains stream wrongly!\n");
+    if (!sameorbit(e7frozen))
+        printf("Agh, E7 orbit graph differs!\n");
+    if (!untangles(e7frozen))
+        printf("Agh, E7 crossing reduction is wrong!\n");
+    cg = linear_coxeter(4, 5);
+    ringnodes(cg, "1001");
+    if (!sameorbit(FaceOrbitPoset{cg}.freeze()))
+        printf("Agh, H4 orbit graph differs!\n");
+    cg = linear_coxeter(5);
+    ringnodes(cg, "00000"); // only the head and the empty face; ranks 1 to 4 are empty
+    FaceOrbitPoset a5{cg};
+    const HasseDiagram a5frozen = a5.freeze();
+    if (!samefrozen(a5, a5frozen) || !streams(a5frozen) || !sameorbit(a5frozen))
+        printf("Agh, frozen A5 differs!\n");
+
+    /* The flag f-vector counts each chain once, however many ways there
+     * are between its faces */
+    if (!flagcounts(e7frozen) || !flagcounts(a5frozen))
+        printf("Agh, the flag f-vector of E7 or A5 is wrong!\n");
+    if (flagvector(e7frozen).back() != e7frozen.numpaths()[e7frozen.head()])
+        printf("Agh, the chains of every rank of E7 aren't its flag orbits!\n");
+    for (const char* ringing : {"10110", "01011", "00001"}) {
+        cg = coxeterD(5);
+        ringnodes(cg, ringing);
+        if (!flagcounts(FaceOrbitPoset{cg}.freeze()))
+            printf("Agh, the flag f-vector of D5 %s is wrong!\n", ringing);
+    }
+    /* and in omnitruncated A6 every set of nodes is a face, so the chains
+     * with ranks s_1 < ... < s_k are 6!/(s_1! (s_2 - s_1)! ... (6 - s_k)!) */
+    cg = linear_coxeter(6);
+    ringnodes(cg, string(6, '1'));
+    {
+        const std::vector<Count128> flags = flagvector(FaceOrbitPoset{cg}.freeze());
+        const unsigned fac[] = {1, 1, 2, 6, 24, 120, 720};
+        for (unsigned set = 0; set < 64; ++set) {
+            unsigned ways = 720, last = 0;
+            for (unsigned r = 0; r < 6; ++r) {
+                if (set >> r & 1) {
+                    ways /= fac[r - last];
+                    last = r;
+                }
+            }
+            ways /= fac[6 - last];
+            if (flags[set] != Count128(ways))
+                printf("Agh, omnitruncated A6 has %s chains of ranks %x, not %u!\n",
+                       flags[set].str().c_str(), set, ways);
+        }
+    }
+
+    /* Saved and mapped back, it's the same poset and orbit graph, and
+     * saving that again gives the same bytes */
+    const auto e7orbit = makeCompactOrbit(e7frozen);
+    saveorbits("posettest.orb", e7frozen, e7orbit);
+    cg = coxeterE(7);
+    ringnodes(cg, "1010011");
+    {
+        const OrbitFile loaded = loadorbits("posettest.orb", cg);
+        if (!samefrozen(e7, loaded.hasse) || edgelist(loaded.orbit) != edgelist(e7orbit)
+                || !streams(loaded.hasse))
+            printf("Agh, E7 comes back from its file different!\n");
+        saveorbits("posettest2.orb", loaded.hasse, loaded.orbit);
+    }
+    auto contents = [](const char* path) {
+        std::ifstream file(path, std::ios::binary);
+        return string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    const string saved = contents("posettest.orb");
+    if (saved != contents("posettest2.orb"))
+        printf("Agh, saving E7 twice gives different files!\n");
+    std::ofstream("posettest2.orb", std::ios::binary) << saved.substr(0, saved.size() - 8);
+    int refused = 0;
+    for (const char* path : {"posettest2.orb", "no such file"}) {
+        try {
+            loadorbits(path);
+        } catch (const std::runtime_error&) {
+            ++refused;
+        }
+    }
+    try {
+        loadorbits("posettest.orb", coxeterE(7)); // not ringed the same
+    } catch (const std::runtime_error&) {
+        ++refused;
+    }
+    if (refused != 3)
+        printf("Agh, only %d of 3 bad loads refused!\n", refused);
+    std::remove("posettest.orb");
+    std::remove("posettest2.orb");
+
+    /* Walking from ringing to ringing gives the same posets */
+    if (!samewalk(coxeterD(5)))
+        printf("Agh, walking through D5 differs!\n");
+    if (!samewalk(linear_coxeter(4, 5)))
+        printf("Agh, walking through H4 differs!\n");
+    cg = linear_coxeter(6);
+    boost::remove_edge(2u, 3u, cg);
+    if (!samewalk(cg))
+        printf("Agh, walking through A3+A3 differs!\n");
+
+    /* Growing a walk a node at a time gives the same posets */
+    if (!samegrowth('A', "101", 9))
+        printf("Agh, growing A_n differs!\n");
+    if (!samegrowth('B', "011", 8))
+        printf("Agh, growing B_n differs!\n");
+    if (!samegrowth('D', "1", 8))
+        printf("Agh, growing D_n differs!\n");
+    if (!samegrowth('D', "0101", 8))
+        printf("Agh, growing D_n differs!\n");
+    if (!samegrowth('E', "1001", 8))
+        printf("Agh, growing E_n differs!\n");
+    {
+        RingingWalk walk{linear_coxeter(4)};
+        try {
+            walk.insertnode(linear_coxeter(5), 2);
+            printf("Agh, growing A4 into A5 in the middle wasn't refused!\n");
+        } catch (std::invalid_argument&) {
+        }
+        walk.insertnode(coxeterD(5), 3); // but D5 is A4 with a leg put in
+        if (!samefrozen(FaceOrbitPoset{coxeterD(5)}, walk.freeze()))
+            printf("Agh, growing A4 into D5 differs!\n");
+    }
+
+    /* Rebuilding in place gives the same poset, from the same arena blocks,
+     * and neither the links nor the nodes make allocations of their own */
+    FaceOrbitPoset reused;
+    cg = linear_coxeter(9);
+    ringnodes(cg, string(9, '1'));
+    std::size_t before = heapallocs;
+    reused.build(cg);
+    const std::size_t first = heapallocs - before, blocks = reused.arena.allocations();
+    std::size_t links = 0;
+    for (const auto& layer : reused.nodes) {
+        for (const auto& nd : layer)
+            links += nd.children.size();
+    }
+    if (reused.arena.bytes() != 2*links*sizeof(const PosetNode*))
+        printf("Agh, the arena holds %zu bytes for %zu links!\n", reused.arena.bytes(), links);
+    reused.build(coxeterE(6)); // something else in between
+    before = heapallocs;
+    reused.build(cg);
+    std::size_t numnodes = 0;
+    for (const auto& layer : reused.nodes)
+        numnodes += layer.size();
+    if (heapallocs - before >= first || heapallocs - before >= numnodes/2
+            || reused.arena.allocations() != blocks)
+        printf("Agh, rebuilding made %zu allocations and %zu blocks, from %zu and %zu!\n",
+               heapallocs - before, reused.arena.allocations(), first, blocks);
+    if (!samestructure(reused, FaceOrbitPoset{cg}))
+        printf("Agh, rebuilt A9 differs!\n");
+
+    /* Count128 reports overflow instead of wrapping */
+    Count128 big{1};
+    bool threw = false;
+    try {
+        for (int i = 0; i < 3; ++i)
+            big *= Count128{~uint64_t{0}};
+    } catch (const std::overflow_error&) {
+        threw = true;
+    }
+    if (!threw)
+        printf("Agh, no overflow from 2^192!\n");
+    CHECK_EQ(Count128{~uint64_t{0}} * Count128{~uint64_t{0}} + Count128{2}
+                 * Count128{~uint64_t{0}},
+             Count128{~uint64_t{0}} * Count128{~uint64_t{0}} + Count128{~uint64_t{0}}
+                 + Count128{~uint64_t{0}});
+    threw = false;
+    try {
+        Count128{2} - Count128{3};
+    } catch (const std::overflow_error&) {
+        threw = true;
+    }
+    if (!threw)
+        printf("Agh, no overflow from 2 - 3!\n");
+    CHECK_EQ(Count128{~uint64_t{0}} * Count128{4} - Count128{~uint64_t{0}},
+             Count128{~uint64_t{0}} * Count128{3});
+    if (Count128{~uint64_t{0}}.str() != "18446744073709551615")
+        printf("Agh, bad decimal conversion!\n");
+
+    return 0;
+}
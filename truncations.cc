@@ -6,10 +6,23 @@
 #include "TeXout.h"
 #include "coxeter.h"
 #include "poset.h"
+#include "orbitgraph.h"
+#include "orbitcache.h"
+#include "intervalcache.h"
+#include "symmetry.h"
+#include "ringingwalk.h"
+#include "pathcount.h"
+#include "flagvector.h"
+#include "grouporder.h"
 #include "binom.h"
 #include "polynomial.h"
+#include <algorithm> // find
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <memory> // unique_ptr
+#include <stdexcept>
+#include <unordered_map>
 #include <boost/program_options.hpp>
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <boost/range/algorithm/count.hpp>
@@ -22,27 +35,185 @@ using boost::range::count;
 using boost::algorithm::all_of;
 
 namespace { // this-file-only (internal linkage)
-    void texgraphs(TeXout& tex, const FaceOrbitPoset& hasse) {
-        auto orbgraph = makeOrbit(hasse);
+    /* The poset drawn with sweeps passes of crossing reduction (see
+     * HasseDiagram::rankorder), and the orbit graph below it */
+    void texgraphs(TeXout& tex, const OrbitFile& orbits, unsigned sweeps) {
         tex << "\\begin{tikzpicture}\n"
-               "\\node (N) {" << env_wrap{"tikzpicture"} << hasse << "};\n"
-               "\\node (O) [below=of N] {" << env_wrap{"tikzpicture"} << orbgraph << "};\n"
-               "\\node[left=of O] {" << hasse.head->numpaths() << " flag orbits:};\n"
+               "\\node (N) {\\begin{tikzpicture}\n";
+        orbits.hasse.to_tikz(tex, sweeps);
+        tex << "\\end{tikzpicture}\n};\n"
+               "\\node (O) [below=of N] {" << env_wrap{"tikzpicture"} << orbits.orbit << "};\n"
+               "\\node[left=of O] {" << orbits.orbit.numvertices() << " flag orbits:};\n"
                "\\end{tikzpicture}\n";
     }
 
-    int output(const po::variables_map& vm, TeXout& tex, const CoxeterGraph& cg) {
-        FaceOrbitPoset hasse{cg};
-        int np = hasse.head->numpaths();
-        if (vm.count("tex") || vm.count("pdf"))
-            texgraphs(tex, hasse);
+    /* Storage reused from one diagram to the next */
+    struct Workspace {
+        IntervalCache memo;
+        FaceOrbitPoset hasse;
+        std::unique_ptr<RingingWalk> walk; // when going through all the ringings,
+                                           // or a family a node at a time
+        PathCount path; // the last path counted
+    };
+
+    /* Is the walk at cg, with its ringing? */
+    bool walkat(const CoxeterGraph& cg, const Workspace& work) {
+        return work.walk && num_vertices(work.walk->diagram()) == num_vertices(cg)
+            && work.walk->ringing() == BitDiagram{cg}.ringed();
+    }
+
+    /* The number of flag orbits of cg: from the walk if it's at this
+     * ringing, by PathCount if cg is a path, or else from the cache (with
+     * the components from table, if given) */
+    Count128 countorbits(const CoxeterGraph& cg, Workspace& work, const FaceTable* table) {
+        if (walkat(cg, work))
+            return work.walk->flagorbits();
+        const std::vector<vsize_t> order = pathorder(cg);
+        if (order.empty())
+            return table ? work.memo.flagorbits(cg, *table) : work.memo.flagorbits(cg);
+        // the linear families grow at the end, so the last path is the
+        // start of this one, and its intervals are kept
+        work.path.assign(pathringing(cg, order));
+        return work.path.flagorbits();
+    }
+
+    /* The number of face orbits of each rank of cg below the head, by
+     * PathCount if it is a path with a node ringed; or else the empty vector */
+    std::vector<Count128> pathfaces(const CoxeterGraph& cg, Workspace& work) {
+        const std::vector<vsize_t> order = pathorder(cg);
+        const std::vector<bool> ringing = pathringing(cg, order);
+        if (std::find(ringing.begin(), ringing.end(), true) == ringing.end())
+            return {};
+        work.path.assign(ringing);
+        std::vector<Count128> faces = work.path.faces();
+        faces.pop_back(); // the whole path, the head
+        return faces;
+    }
+
+    /* The poset of cg, worked out afresh, or from the walk if it's at this
+     * ringing */
+    HasseDiagram makeposet(const CoxeterGraph& cg, Workspace& work, unsigned nthreads) {
+        if (walkat(cg, work))
+            return work.walk->freeze();
+        work.hasse.build(cg, nthreads);
+        return work.hasse.freeze();
+    }
+
+    /* The same, and its orbit graph */
+    OrbitFile makeorbits(const CoxeterGraph& cg, Workspace& work, unsigned nthreads) {
+        OrbitFile orbits;
+        orbits.hasse = makeposet(cg, work, nthreads);
+        orbits.orbit = makeCompactOrbit(orbits.hasse, nthreads);
+        return orbits;
+    }
+
+    /* The same, from the file for cg in the directory dir if it's there,
+     * or else worked out and saved there for next time */
+    OrbitFile cachedorbits(const string& dir, const CoxeterGraph& cg, Workspace& work,
+                           unsigned nthreads) {
+        const string path = dir + '/' + orbitfilename(cg);
+        try {
+            return loadorbits(path, cg);
+        } catch (std::runtime_error&) {
+            // not saved yet (or unreadable): make it again
+        }
+        OrbitFile orbits = makeorbits(cg, work, nthreads);
+        try {
+            saveorbits(path, orbits.hasse, orbits.orbit);
+        } catch (std::runtime_error& e) {
+            std::cerr << "Warning: " << e.what() << '\n';
+        }
+        return orbits;
+    }
+
+    /* The ranks in set (bit r for rank r), as "0,2,3" */
+    string ranklist(std::size_t set) {
+        string list;
+        for (unsigned r = 0; set >> r; ++r) {
+            if (set >> r & 1)
+                list += (list.empty() ? "" : ",") + std::to_string(r);
+        }
+        return list;
+    }
+
+    /* Output for one ringing, with its number of flag orbits put in np.
+     * If known is given, it is that number, already worked out for a
+     * ringing symmetric to this one. Returns false if the number is too big
+     * for a Count128 (and is shown as >2^128), or true otherwise. */
+    bool output(const po::variables_map& vm, TeXout& tex, const CoxeterGraph& cg,
+                Workspace& work, Count128& np, const FaceTable* table = nullptr,
+                const Count128* known = nullptr) {
+        const unsigned nthreads = vm["threads"].as<unsigned>();
+        bool fits = true;
+        // a path's faces of each rank are counted without its poset
+        const std::vector<Count128> pathfvector = vm.count("fvector") ? pathfaces(cg, work)
+                                                                      : std::vector<Count128>{};
+        HasseDiagram hd; // the poset, if it's needed
+        if (vm.count("tex") || vm.count("pdf")) {
+            const OrbitFile orbits = vm.count("cache")
+                ? cachedorbits(vm["cache"].as<string>(), cg, work, nthreads)
+                : makeorbits(cg, work, nthreads);
+            np = orbits.orbit.numvertices();
+            texgraphs(tex, orbits, vm["untangle"].as<unsigned>());
+            hd = orbits.hasse;
+        } else { // only counting, so the orbit graph isn't needed
+            try {
+                np = known ? *known : countorbits(cg, work, table);
+            } catch (const std::overflow_error&) {
+                fits = false;
+            }
+            if ((vm.count("fvector") && pathfvector.empty()) || vm.count("flagvector")
+                    || vm.count("polytope"))
+                hd = makeposet(cg, work, nthreads);
+        }
         if (vm.count("count"))
             std::cout << "t_{" << ringedlist(cg) << "}("
                       << num_vertices(cg) << ")\t"
-                      << np << '\n';
+                      << (fits ? np.str() : ">2^128") << '\n';
         // Ideally, this would factor in the maximum width of the ringed list
         // and align the program's output appropriately
-        return np;
+        if (vm.count("fvector")) {
+            std::cout << "t_{" << ringedlist(cg) << "}("
+                      << num_vertices(cg) << ") f-vector:";
+            if (pathfvector.empty()) {
+                for (auto f : fvector(hd))
+                    std::cout << ' ' << f;
+            } else {
+                for (auto f : pathfvector)
+                    std::cout << ' ' << f;
+            }
+            std::cout << '\n';
+        }
+        if (vm.count("flagvector")) {
+            const std::vector<Count128> flags = flagvector(hd);
+            std::cout << "t_{" << ringedlist(cg) << "}("
+                      << num_vertices(cg) << ") flag f-vector:";
+            for (std::size_t set = 0; set < flags.size(); ++set)
+                std::cout << " f_{" << ranklist(set) << "}=" << flags[set];
+            std::cout << '\n';
+        }
+        if (vm.count("polytope")) {
+            std::cout << "t_{" << ringedlist(cg) << "}("
+                      << num_vertices(cg) << ") polytope:";
+            try {
+                // each rank's faces are the sizes of its orbits added up
+                const std::vector<Count128> sizes = orbitsizes(hd);
+                std::vector<Count128> faces(hd.rank(hd.head()));
+                for (HasseDiagram::nodeid i = 0; i < hd.head(); ++i)
+                    faces[hd.rank(i)] += sizes[i];
+                Count128 flags;
+                for (auto f : flagsizes(hd))
+                    flags += f;
+                for (auto f : faces)
+                    std::cout << ' ' << f;
+                std::cout << "; " << flags << " flags\n";
+            } catch (const std::domain_error&) {
+                std::cout << " the group is infinite\n";
+            } catch (const std::overflow_error&) {
+                std::cout << " too many to count in 128 bits\n";
+            }
+        }
+        return fits;
     }
 
     template <typename Container>
@@ -55,7 +226,7 @@ int main(int argc, char* argv[]) {
     std::ios_base::sync_with_stdio(false);
 
     int maxnodes, numnode{0};
-    string texfile, diagram, trunc;
+    string texfile, diagram, trunc, family;
     bool usage;
 
     po::options_description desc("Allowed options");
@@ -70,14 +241,31 @@ int main(int argc, char* argv[]) {
         ("truncate,t", po::value<string>(&trunc)->value_name("<pattern>"),
            "Truncation pattern: 0 for unringed, 1 for ringed, to apply "
            "starting from node 0. If -d or -n are not specified, "
-           "applied to A_n as n ranges from the length of the pattern "
-           "up to maxnodes.")
+           "applied to X_n as n ranges from the length of the pattern "
+           "up to maxnodes, for the family X given by -f.")
+        ("family,f",   po::value<string>(&family)->value_name("<X>")->default_value("A"),
+           "Family of diagrams for -t without -d or -n: A, B, C, D, E, G, or H")
         ("maxnodes,m", po::value<int>(&maxnodes)->default_value(12),
            "Maximum number of nodes to consider (when -d or -n are not given)")
         ("count,c",
            "Print the number of flag orbits to the console")
+        ("fvector",
+           "Print the number of face orbits of each rank to the console")
+        ("flagvector",
+           "Print the flag f-vector to the console: the number of chains "
+           "of face orbits with each set of ranks")
+        ("polytope",
+           "Print the number of faces of each rank and of flags of the "
+           "polytope itself, from the orders of the Coxeter groups")
+        ("threads,j",  po::value<unsigned>()->value_name("<n>")->default_value(1),
+           "Number of threads to use building each poset and orbit graph")
         ("tex,x",      po::value<string>(&texfile)->implicit_value("output.tex"),
            "Write LaTeX output to the given file")
+        ("untangle,u", po::value<unsigned>()->value_name("<n>")->default_value(0),
+           "Passes of crossing reduction for each Hasse diagram drawn")
+        ("cache",      po::value<string>()->value_name("<dir>"),
+           "Directory to save each poset and orbit graph in for -x, "
+           "and to load them from when they are there already")
         ("pdf,p",
            "Convert TeX output to PDF. Implies -x.");
 
@@ -135,15 +323,41 @@ int main(int argc, char* argv[]) {
         usage = true;
     }
 
+    if (family.size() != 1 || family.find_first_of("ABCDEGH") != 0) {
+        std::cerr << "The family must be one of A, B, C, D, E, G, or H.\n";
+        usage = true;
+    } else if (!vm["family"].defaulted() && numnode != 0) {
+        std::cerr << "-f is only for -t without -d or -n.\n";
+        usage = true;
+    }
+
+    // Counting given ringings goes by IntervalCache, which takes wider
+    // diagrams than the posets and the loop over every ringing do, and by
+    // PathCount for the linear diagrams, which takes any length
+    const bool posets = vm.count("tex") || vm.count("pdf") || vm.count("fvector")
+                        || vm.count("flagvector") || vm.count("polytope");
+    const bool counting = !posets && !trunc.empty();
+    const char kind = vm.count("diagram") ? diagram[0] : vm.count("number") ? 'A' : family[0];
+    const int maxsupported = counting && string("ABCGHI").find(kind) != string::npos
+        ? std::numeric_limits<int>::max()
+        : counting ? IntervalCache::maxnodes : BitDiagram::maxnodes;
+    // the number after I is the edge order: I2(p) always has two nodes
+    const int nodecount = kind == 'I' ? 2 : numnode;
+    if (nodecount > maxsupported || (numnode == 0 && maxnodes > maxsupported)) {
+        std::cerr << "At most " << maxsupported << " nodes are supported.\n";
+        usage = true;
+    }
+
     if (maxnodes <= static_cast<int>(trunc.size())) {
         std::cerr << "Value of maxnodes (-m) must be positive and at least "
                      "as large as the length of <pattern>, if given.\n";
         usage = true;
     }
 
-    if (!vm.count("count") && !vm.count("tex") && !vm.count("pdf")) {
-        std::cerr << "At least one of -c, -x, or -p must be specified, "
-                     "or there is no output.\n";
+    if (!vm.count("count") && !vm.count("tex") && !vm.count("pdf")
+            && !vm.count("fvector") && !vm.count("flagvector") && !vm.count("polytope")) {
+        std::cerr << "At least one of -c, -x, -p, --fvector, --flagvector, "
+                     "or --polytope must be specified, or there is no output.\n";
         usage = true;
     }
 
@@ -156,13 +370,30 @@ int main(int argc, char* argv[]) {
     TeXout tex;
     tex.usetikzlibrary("positioning");
     CoxeterGraph tcg;
+    Workspace work; // shared by every diagram and ringing
 
     if (numnode == 0) { // no diagram specified
         std::vector<int> orbs;
+        bool fitsint = true; // seqsolver works with ints; stop at the first count too big
         for (numnode = trunc.size(); numnode <= maxnodes; ++numnode) {
-            tcg = linear_coxeter(numnode);
+            tcg = coxeter_dispatch(family[0], numnode);
             ringnodes(tcg, trunc);
-            orbs.push_back(output(vm, tex, tcg));
+            // the posets to draw (or count chains in) are those of the last
+            // diagram with a node put in, so its faces are kept and only the
+            // new ones found
+            if (!posets || numnode > static_cast<int>(FaceTable::maxnodes))
+                work.walk.reset();
+            else if (work.walk)
+                work.walk->insertnode(tcg, newnode(family[0], numnode - 1));
+            else
+                work.walk.reset(new RingingWalk{tcg});
+            if (work.walk)
+                work.walk->moveto(BitDiagram{tcg}.ringed());
+            Count128 np;
+            const bool fits = output(vm, tex, tcg, work, np);
+            fitsint = fitsint && fits && !(Count128(std::numeric_limits<int>::max()) < np);
+            if (fitsint)
+                orbs.push_back(np.as<int>());
         }
         auto binpoly = seqsolver(orbs, trunc.size()),
              binpolym1 = seqsolver(orbs, trunc.size() - 1), // for n - 1
@@ -193,11 +424,33 @@ int main(int argc, char* argv[]) {
 
         if (!trunc.empty()) { // do one truncation of one diagram
             ringnodes(tcg, trunc);
-            output(vm, tex, tcg);
+            Count128 np;
+            output(vm, tex, tcg, work, np);
         } else { // Do all truncations
-            for (unsigned b = 1u; b < (1u << numnode); ++b) {
+            // the shape is the same every time, so work out its components once
+            std::unique_ptr<FaceTable> table;
+            if (nodecount <= static_cast<int>(FaceTable::maxnodes))
+                table.reset(new FaceTable{tcg});
+            // and the posets change a node or two at a time, so a walk
+            // keeps them, with their links and chains, up to date
+            if (table && posets)
+                work.walk.reset(new RingingWalk{tcg});
+            // and ringings which a symmetry of the diagram swaps have the
+            // same count, so only the least of each is counted
+            const DiagramSymmetry symmetry{tcg};
+            std::unordered_map<nodemask, Count128> counted;
+            const nodemask last = nodecount == 64 ? ~nodemask{0} : nodebit(nodecount) - 1;
+            for (nodemask b = 1; b != 0 && b <= last; ++b) {
                 ringnodes(tcg, b);
-                output(vm, tex, tcg);
+                if (work.walk)
+                    work.walk->moveto(b);
+                const nodemask least = symmetry.canonical(b);
+                const auto same = counted.find(least);
+                Count128 np;
+                const bool fits = output(vm, tex, tcg, work, np, table.get(),
+                                         same == counted.end() ? nullptr : &same->second);
+                if (fits && b == least) // the others are never looked up
+                    counted[b] = np;
             }
         }
     }